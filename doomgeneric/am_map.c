@@ -198,9 +198,6 @@ static int 	grid = 0;
 static int 	leveljuststarted = 1; 	// kluge until AM_LevelInit() is called
 
 boolean    	automapactive = false;
-static int 	finit_width = SCREENWIDTH;
-static int 	finit_height = SCREENHEIGHT - 32;
-
 // location of window on screen
 static int 	f_x;
 static int	f_y;
@@ -520,8 +517,8 @@ void AM_LevelInit(void)
     leveljuststarted = 0;
 
     f_x = f_y = 0;
-    f_w = finit_width;
-    f_h = finit_height;
+    f_w = SCREENWIDTH;
+    f_h = SCREENHEIGHT - (32 << hires);
 
     AM_clearMarks();
 
@@ -833,7 +830,15 @@ void AM_Ticker (void)
 //
 void AM_clearFB(int color)
 {
+#ifdef COLUMN_MAJOR_VIDEO
+    int x;
+
+    // Each column runs on under the status bar.
+    for (x = 0; x < f_w; x++)
+	memset(fb + SCREENOFS(x, 0), color, f_h);
+#else
     memset(fb, color, f_w*f_h);
+#endif
 }
 
 
@@ -1007,7 +1012,7 @@ AM_drawFline
 	return;
     }
 
-#define PUTDOT(xx,yy,cc) fb[(yy)*f_w+(xx)]=(cc)
+#define PUTDOT(xx,yy,cc) fb[SCREENOFS(xx, yy)]=(cc)
 
     dx = fl->b.x - fl->a.x;
     ax = 2 * (dx<0 ? -dx : dx);
@@ -1318,12 +1323,12 @@ void AM_drawMarks(void)
 	{
 	    //      w = SHORT(marknums[i]->width);
 	    //      h = SHORT(marknums[i]->height);
-	    w = 5; // because something's wrong with the wad, i guess
-	    h = 6; // because something's wrong with the wad, i guess
+	    w = 5 << hires; // because something's wrong with the wad, i guess
+	    h = 6 << hires; // because something's wrong with the wad, i guess
 	    fx = CXMTOF(markpoints[i].x);
 	    fy = CYMTOF(markpoints[i].y);
 	    if (fx >= f_x && fx <= f_w - w && fy >= f_y && fy <= f_h - h)
-		V_DrawPatch(fx, fy, marknums[i]);
+		V_DrawPatch(fx >> hires, fy >> hires, marknums[i]);
 	}
     }
 
@@ -1331,7 +1336,7 @@ void AM_drawMarks(void)
 
 void AM_drawCrosshair(int color)
 {
-    fb[(f_w*(f_h+1))/2] = color; // single point for now
+    fb[SCREENOFS(f_w/2, f_h/2)] = color; // single point for now
 
 }
 
@@ -113,6 +113,17 @@ static boolean local_playeringame[NET_MAXPLAYERS];
 
 static int player_class;
 
+// Extra tics that may buffer up in single player before the rest
+// of the time is dropped.  Frame skipping raises this, so that time
+// spent on a slow frame is run rather than lost.
+
+int extraticbuffer = 0;
+
+// If true, TryRunTics returns when no tic is due rather than
+// waiting for one, so that frames are drawn in between tics.
+
+boolean noticwait = false;
+
 
 // 35 fps clock adjusted by offsetms milliseconds
 
@@ -159,7 +170,8 @@ static boolean BuildNewTic(void)
        // If playing single player, do not allow tics to buffer
        // up very far
 
-       if (!net_client_connected && maketic - gameticdiv > 2)
+       if (!net_client_connected
+        && maketic - gameticdiv > 2 + extraticbuffer)
            return false;
 
        // Never go more than ~200ms ahead
@@ -169,7 +181,8 @@ static boolean BuildNewTic(void)
     }
     else
     {
-       if (maketic - gameticdiv >= 5)
+       if (maketic - gameticdiv >= 5
+        + (net_client_connected ? 0 : extraticbuffer))
            return false;
     }
 
@@ -200,6 +213,10 @@ static boolean BuildNewTic(void)
 //
 int      lasttime;
 
+// Tics of time lost by NetUpdate since TryRunTics was entered,
+// because too many were already waiting to be run.
+static int droppedtics;
+
 void NetUpdate (void)
 {
     int nowtime;
@@ -244,11 +261,55 @@ void NetUpdate (void)
     {
         if (!BuildNewTic())
         {
+            // The rest of the time is lost to the game.
+
+            droppedtics += newtics - i;
             break;
         }
     }
 }
 
+//
+// D_TicsBehind
+// Returns how many tics are due but have not been run yet,
+// counting time that has passed without being made into tics
+// and time lost since TryRunTics was last entered.
+//
+
+int D_TicsBehind(void)
+{
+    if (singletics)
+        return 0;
+
+    return GetAdjustedTime() / ticdup - lasttime
+         + maketic - gametic / ticdup + droppedtics;
+}
+
+//
+// D_TicFraction
+// Returns how far the clock is into the tic after the last one
+// that was due, as a fraction of FRACUNIT.  While tics are due
+// that have not been run, returns FRACUNIT.
+//
+
+fixed_t D_TicFraction(void)
+{
+    int time_ms;
+
+    if (singletics || D_TicsBehind() > 0)
+        return FRACUNIT;
+
+    time_ms = I_GetTimeMS();
+
+    if (new_sync)
+    {
+        time_ms += (offsetms / FRACUNIT);
+    }
+
+    return ((time_ms * TICRATE) % (1000 * ticdup)) * (FRACUNIT / 8)
+         / (125 * ticdup);
+}
+
 static void D_Disconnected(void)
 {
     // In drone mode, the game cannot continue once disconnected.
@@ -713,6 +774,8 @@ void TryRunTics (void)
     int	availabletics;
     int	counts;
 
+    droppedtics = 0;
+
     // get real tics
     entertic = I_GetTime() / ticdup;
     realtics = entertic - oldentertics;
@@ -762,6 +825,14 @@ void TryRunTics (void)
     if (counts < 1)
 	counts = 1;
 
+    // Draw a frame rather than wait, when frames are drawn in
+    // between tics.
+
+    if (noticwait && PlayersInGame() && lowtic < gametic/ticdup + counts)
+    {
+        return;
+    }
+
     // wait for new tics if needed
 
     while (!PlayersInGame() || lowtic < gametic/ticdup + counts)
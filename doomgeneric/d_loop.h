@@ -20,6 +20,7 @@
 #define __D_LOOP__
 
 #include "net_defs.h"
+#include "m_fixed.h"
 
 // Callback function invoked while waiting for the netgame to start.
 // The callback is invoked when new players are ready. The callback
@@ -61,6 +62,12 @@ void D_QuitNetGame (void);
 //? how many ticks to run?
 void TryRunTics (void);
 
+// How many tics the game is running behind the clock.
+int D_TicsBehind (void);
+
+// How far the clock is into the next tic, out of FRACUNIT.
+fixed_t D_TicFraction (void);
+
 // Called at start of game loop to initialize timers
 void D_StartGameLoop(void);
 
@@ -75,6 +82,8 @@ void D_StartNetGame(net_gamesettings_t *settings,
                     netgame_startup_callback_t callback);
 
 extern boolean singletics;
+extern int extraticbuffer;
+extern boolean noticwait;
 extern int gametic, ticdup;
 
 #endif
@@ -71,6 +71,7 @@
 #include "p_setup.h"
 #include "r_local.h"
 #include "statdump.h"
+#include "z_trace.h"
 
 #include "d_main.h"
 
@@ -127,6 +128,20 @@ char		mapdir[1024];           // directory of development maps
 
 int             show_endoom = 1;
 
+// Most frames in a row that may go undrawn while the game
+// runs behind the clock.  0 draws every frame.
+int             render_frame_skip = 0;
+
+static int      framesskipped;
+static int      framesoffered;
+static int      skiprun;
+
+// If non-zero, frames are drawn in between tics, at most this
+// many a second.  0 draws one frame a tic.
+int             uncapped_framerate = 0;
+
+static int      lastframems;
+
 
 void D_ConnectNetGame(void);
 void D_CheckNetGame(void);
@@ -155,6 +170,102 @@ void D_ProcessEvents (void)
 
 
 
+//
+// STARTUP TIMES
+// Each phase runs from its D_StartupPhase to the next.
+//
+#define MAXSTARTUPPHASES	32
+
+static char*	startupphases[MAXSTARTUPPHASES];
+static int	startuptimes[MAXSTARTUPPHASES+1];
+static int	numstartupphases;
+
+//
+// D_StartupPhase
+//
+void D_StartupPhase (char *name)
+{
+    if (numstartupphases == MAXSTARTUPPHASES)
+	return;
+
+    startupphases[numstartupphases] = name;
+    startuptimes[numstartupphases] = I_GetTimeMS();
+    numstartupphases++;
+}
+
+//
+// D_StartupReport
+// Called as each frame goes up. After the first, with -devparm,
+//  prints how long each phase of startup took.
+//
+static void D_StartupReport (void)
+{
+    int		i;
+
+    if (numstartupphases == 0)
+	return;
+
+    startuptimes[numstartupphases] = I_GetTimeMS();
+
+    if (devparm)
+    {
+	printf ("D_StartupReport: first frame up %i ms into startup\n",
+		startuptimes[numstartupphases] - startuptimes[0]);
+
+	for (i=0 ; i<numstartupphases ; i++)
+	{
+	    printf ("    %-20s %6i ms\n", startupphases[i],
+		    startuptimes[i+1] - startuptimes[i]);
+	}
+    }
+
+    numstartupphases = 0;
+}
+
+//
+// D_TimeLumpLookups
+// With -timelookups, times building the lump hash table, then a
+//  number of passes looking up every lump by name and as many names
+//  that are not there.
+//
+#define LOOKUPPASSES	100
+
+static void D_TimeLumpLookups (void)
+{
+    char	name[9];
+    int		start;
+    int		built;
+    int		found;
+    int		pass;
+    int		i;
+
+    start = I_GetTimeMS();
+    W_GenerateHashTable();
+    built = I_GetTimeMS();
+
+    found = 0;
+    name[8] = '\0';
+
+    for (pass=0 ; pass<LOOKUPPASSES ; pass++)
+    {
+	for (i=0 ; i<numlumps ; i++)
+	{
+	    memcpy (name, lumpinfo[i].name, 8);
+
+	    if (W_CheckNumForName (name) >= 0)
+		found++;
+
+	    if (W_CheckNumForName ("-NOLUMP-") >= 0)
+		found++;
+	}
+    }
+
+    printf ("D_TimeLumpLookups: hash table for %u lumps built in %i ms, "
+	    "%u lookups (%i found) in %i ms\n", numlumps, built - start,
+	    2 * LOOKUPPASSES * numlumps, found, I_GetTimeMS() - built);
+}
+
+
 //
 // D_Display
 //  draw current display, possibly wiping it from the previous
@@ -177,6 +288,7 @@ void D_Display (void)
     int				nowtime;
     int				tics;
     int				wipestart;
+    int				starttime;
     int				y;
     boolean			done;
     boolean			wipe;
@@ -184,6 +296,8 @@ void D_Display (void)
 
     if (nodrawers)
     	return;                    // for comparative timing / profiling
+
+    starttime = I_GetTimeMS ();
 		
     redrawsbar = false;
     
@@ -215,12 +329,12 @@ void D_Display (void)
 			break;
 		if (automapactive)
 			AM_Drawer ();
-		if (wipe || (viewheight != 200 && fullscreen) )
+		if (wipe || (viewheight != SCREENHEIGHT && fullscreen) )
 			redrawsbar = true;
 		if (inhelpscreensstate && !inhelpscreens)
 			redrawsbar = true;              // just put away the help screen
-		ST_Drawer (viewheight == 200, redrawsbar );
-		fullscreen = viewheight == 200;
+		ST_Drawer (viewheight == SCREENHEIGHT, redrawsbar );
+		fullscreen = viewheight == SCREENHEIGHT;
 		break;
 
       case GS_INTERMISSION:
@@ -258,7 +372,7 @@ void D_Display (void)
     }
 
     // see if the border needs to be updated to the screen
-    if (gamestate == GS_LEVEL && !automapactive && scaledviewwidth != 320)
+    if (gamestate == GS_LEVEL && !automapactive && scaledviewwidth != SCREENWIDTH)
     {
 		if (menuactive || menuactivestate || !viewactivestate)
 			borderdrawcount = 3;
@@ -287,8 +401,9 @@ void D_Display (void)
 		if (automapactive)
 			y = 4;
 		else
-			y = viewwindowy+4;
-		V_DrawPatchDirect(viewwindowx + (scaledviewwidth - 68) / 2, y,
+			y = (viewwindowy >> hires) + 4;
+		V_DrawPatchDirect((viewwindowx >> hires)
+		                      + ((scaledviewwidth >> hires) - 68) / 2, y,
 							  W_CacheLumpName (DEH_String("M_PAUSE"), PU_CACHE));
     }
 
@@ -302,6 +417,12 @@ void D_Display (void)
     if (!wipe)
     {
 	I_FinishUpdate ();              // page flip or blit buffer
+	D_StartupReport ();
+
+	// let the governor see how long the view took
+	if (gamestate == GS_LEVEL && !automapactive && gametic)
+	    R_UpdateGovernor (I_GetTimeMS () - starttime);
+
 	return;
     }
     
@@ -325,6 +446,7 @@ void D_Display (void)
 	I_UpdateNoBlit ();
 	M_Drawer ();                            // menu is drawn even on top of wipes
 	I_FinishUpdate ();                      // page flip or blit buffer
+	D_StartupReport ();
     } while (!done);
 }
 
@@ -366,6 +488,11 @@ void D_BindVariables(void)
     M_BindVariable("snd_channels",           &snd_channels);
     M_BindVariable("vanilla_savegame_limit", &vanilla_savegame_limit);
     M_BindVariable("vanilla_demo_limit",     &vanilla_demo_limit);
+    M_BindVariable("vanilla_render_limit",   &vanilla_render_limit);
+    M_BindVariable("render_frame_budget",    &render_frame_budget);
+    M_BindVariable("render_threads",         &render_threads);
+    M_BindVariable("render_frame_skip",      &render_frame_skip);
+    M_BindVariable("uncapped_framerate",     &uncapped_framerate);
     M_BindVariable("show_endoom",            &show_endoom);
 
     // Multiplayer chat macros
@@ -402,17 +529,100 @@ boolean D_GrabMouseCallback(void)
     return (gamestate == GS_LEVEL) && !demoplayback && !advancedemo;
 }
 
+//
+// D_SkipFrame
+// Called before each frame is drawn.  While tics are due that
+// have not been run, up to render_frame_skip frames in a row
+// are left undrawn so that the time goes on running tics.
+// Wipes and screens other than the level are always drawn.
+//
+
+static boolean D_SkipFrame(void)
+{
+    boolean skip;
+
+    if (render_frame_skip <= 0)
+        return false;
+
+    skip = gamestate == GS_LEVEL
+        && gamestate == wipegamestate
+        && skiprun < render_frame_skip
+        && D_TicsBehind() > 0;
+
+    if (skip)
+    {
+        ++skiprun;
+        ++framesskipped;
+    }
+    else
+    {
+        skiprun = 0;
+    }
+
+    if (++framesoffered == 10 * TICRATE)
+    {
+        if (devparm)
+        {
+            printf("D_SkipFrame: skipped %i of %i frames (%i%%)\n",
+                   framesskipped, framesoffered,
+                   framesskipped * 100 / framesoffered);
+        }
+
+        framesskipped = 0;
+        framesoffered = 0;
+    }
+
+    return skip;
+}
+
+//
+// D_FrameDue
+// With an uncapped framerate, TryRunTics does not wait for the
+// next tic, and a frame is drawn whenever one is due.  The input
+// held now is read for it, so that the view turns at once.
+//
+
+static boolean D_FrameDue(void)
+{
+    int nowms;
+
+    if (uncapped_framerate <= 0)
+    {
+        fractionaltic = FRACUNIT;
+        localview = false;
+        return true;
+    }
+
+    nowms = I_GetTimeMS();
+
+    if (nowms - lastframems < 1000 / uncapped_framerate)
+    {
+        I_Sleep(1);
+        return false;
+    }
+
+    lastframems = nowms;
+
+    I_StartTic();
+    D_ProcessEvents();
+
+    fractionaltic = D_TicFraction();
+    localview = G_LocalTurn(fractionaltic, &localviewturn);
+
+    return true;
+}
+
 void doomgeneric_Tick()
 {
     // frame syncronous IO operations
     I_StartFrame ();
 
-    TryRunTics (); // will run at least one tic
+    TryRunTics (); // will run at least one tic, unless uncapped
 
     S_UpdateSounds (players[consoleplayer].mo);// move positional sounds
 
     // Update display, next frame, with current state.
-    if (screenvisible)
+    if (screenvisible && D_FrameDue() && !D_SkipFrame())
     {
         D_Display ();
     }
@@ -437,8 +647,10 @@ void D_DoomLoop (void)
 
     main_loop_started = true;
 
+    D_StartupPhase("TryRunTics");
     TryRunTics();
 
+    D_StartupPhase("I_InitGraphics");
     I_SetWindowTitle(gamedescription);
     I_GraphicsCheckCommandLine();
     I_SetGrabMouseCallback(D_GrabMouseCallback);
@@ -455,6 +667,7 @@ void D_DoomLoop (void)
         wipegamestate = gamestate;
     }
 
+    D_StartupPhase("first frame");
     doomgeneric_Tick();
 }
 
@@ -1175,9 +1388,40 @@ void D_DoomMain (void)
 
     I_PrintBanner(PACKAGE_STRING);
 
+    D_StartupPhase("Z_Init");
     DEH_printf("Z_Init: Init zone memory allocation daemon. \n");
     Z_Init ();
 
+    //!
+    // @arg <file>
+    // @category obscure
+    //
+    // Record every allocation made in the zone to the given file.
+    //
+
+    p = M_CheckParmWithArgs("-zonetrace", 1);
+
+    if (p)
+    {
+        Z_StartTrace(myargv[p + 1]);
+    }
+
+    //!
+    // @arg <file>
+    // @category obscure
+    //
+    // Replay the allocations recorded with -zonetrace in the given
+    // file, print how long the zone took over them, and quit.
+    //
+
+    p = M_CheckParmWithArgs("-zonereplay", 1);
+
+    if (p)
+    {
+        Z_ReplayTrace(myargv[p + 1]);
+        exit(0);
+    }
+
 #ifdef FEATURE_MULTIPLAYER
     //!
     // @category net
@@ -1272,6 +1516,19 @@ void D_DoomMain (void)
 
     I_DisplayFPSDots(devparm);
 
+    //!
+    // @category obscure
+    //
+    // Check the fixed point division against the 64-bit reference
+    // for a sweep of inputs, time it, and exit.
+    //
+
+    if (M_CheckParm ("-fixedcheck"))
+    {
+        M_FixedCheck();
+        exit(0);
+    }
+
     //!
     // @category net
     // @vanilla
@@ -1350,10 +1607,13 @@ void D_DoomMain (void)
     }
     
     // init subsystems
+    I_InitScreenScale ();
+
     DEH_printf("V_Init: allocate screens.\n");
     V_Init ();
 
     // Load configuration files before initialising other subsystems.
+    D_StartupPhase("M_LoadDefaults");
     DEH_printf("M_LoadDefaults: Load system defaults.\n");
     M_SetConfigFilenames("default.cfg", PROGRAM_PREFIX "doom.cfg");
     D_BindVariables();
@@ -1362,6 +1622,47 @@ void D_DoomMain (void)
     // Save configuration at exit.
     I_AtExit(M_SaveDefaults, false);
 
+    //!
+    // @arg <n>
+    // @category video
+    //
+    // While the game is running behind the clock, leave up to n
+    // frames in a row undrawn so that it can catch up.  0 draws
+    // every frame.
+    //
+
+    p = M_CheckParmWithArgs("-frameskip", 1);
+
+    if (p > 0)
+    {
+        render_frame_skip = atoi(myargv[p+1]);
+    }
+
+    //!
+    // @arg <fps>
+    // @category video
+    //
+    // Draw up to fps frames a second in between the 35 tics a
+    // second, moving everything part of the way to where the next
+    // tic puts it.
+    //
+
+    p = M_CheckParmWithArgs("-uncapped", 1);
+
+    if (p > 0)
+    {
+        uncapped_framerate = atoi(myargv[p+1]);
+    }
+
+    noticwait = uncapped_framerate > 0;
+
+    // Run the time a slow frame took instead of dropping it.
+
+    if (render_frame_skip > 0)
+    {
+        extraticbuffer = 4;
+    }
+
     // Find main IWAD file and load it.
     iwadfile = D_FindIWAD(IWAD_MASK_DOOM, &gamemission);
 
@@ -1375,6 +1676,7 @@ void D_DoomMain (void)
 
     modifiedgame = false;
 
+    D_StartupPhase("W_Init");
     DEH_printf("W_Init: Init WADfiles.\n");
     D_AddFile(iwadfile);
 #if ORIGCODE
@@ -1513,7 +1815,18 @@ void D_DoomMain (void)
     I_AtExit((atexit_func_t) G_CheckDemoStatus, true);
 
     // Generate the WAD hash table.  Speed things up a bit.
-    W_GenerateHashTable();
+
+    //!
+    // @category obscure
+    //
+    // Time building the lump hash table and looking up every lump
+    // by name, and print how long each took.
+    //
+
+    if (M_CheckParm("-timelookups"))
+        D_TimeLumpLookups();
+    else
+        W_GenerateHashTable();
 
     // Load DEHACKED lumps from WAD files - but only if we give the right
     // command line parameter.
@@ -1607,6 +1920,7 @@ void D_DoomMain (void)
         I_PrintDivider();
     }
 
+    D_StartupPhase("I_Init");
     DEH_printf("I_Init: Setting up machine state.\n");
     I_CheckIsScreensaver();
     I_InitTimer();
@@ -1757,26 +2071,33 @@ void D_DoomMain (void)
         startloadgame = -1;
     }
 
+    D_StartupPhase("M_Init");
     DEH_printf("M_Init: Init miscellaneous info.\n");
     M_Init ();
 
+    D_StartupPhase("R_Init");
     DEH_printf("R_Init: Init DOOM refresh daemon - ");
     R_Init ();
 
+    D_StartupPhase("P_Init");
     DEH_printf("\nP_Init: Init Playloop state.\n");
     P_Init ();
 
+    D_StartupPhase("S_Init");
     DEH_printf("S_Init: Setting up sound.\n");
     S_Init (sfxVolume * 8, musicVolume * 8);
 
+    D_StartupPhase("D_CheckNetGame");
     DEH_printf("D_CheckNetGame: Checking network game status.\n");
     D_CheckNetGame ();
 
     PrintGameVersion();
 
+    D_StartupPhase("HU_Init");
     DEH_printf("HU_Init: Setting up heads up display.\n");
     HU_Init ();
 
+    D_StartupPhase("ST_Init");
     DEH_printf("ST_Init: Init status bar.\n");
     ST_Init ();
 
@@ -1826,6 +2147,8 @@ void D_DoomMain (void)
         return;
     }
 
+    D_StartupPhase("game start");
+
     if (startloadgame >= 0)
     {
         M_StringCopy(file, P_SaveGameFile(startloadgame), sizeof(file));
@@ -38,6 +38,10 @@ void D_PageDrawer (void);
 void D_AdvanceDemo (void);
 void D_DoAdvanceDemo (void);
 void D_StartTitle (void);
+
+// Starts timing a phase of startup, ending the one before.
+// With -devparm the times are printed once the first frame is up.
+void D_StartupPhase (char *name);
  
 //
 // GLOBAL VARIABLES
@@ -45,6 +49,9 @@ void D_StartTitle (void);
 
 extern  gameaction_t    gameaction;
 
+// Frames per second to draw between tics at, or 0 to draw once a tic.
+extern  int             uncapped_framerate;
+
 
 #endif
 
@@ -238,23 +238,19 @@ void F_TextWrite (void)
     
     // erase the entire screen to a tiled background
     src = W_CacheLumpName ( finaleflat , PU_CACHE);
-    dest = I_VideoBuffer;
 	
     for (y=0 ; y<SCREENHEIGHT ; y++)
     {
-	for (x=0 ; x<SCREENWIDTH/64 ; x++)
-	{
-	    memcpy (dest, src+((y&63)<<6), 64);
-	    dest += 64;
-	}
-	if (SCREENWIDTH&63)
+	dest = I_VideoBuffer + SCREENOFS(0, y);
+
+	for (x=0 ; x<SCREENWIDTH ; x++)
 	{
-	    memcpy (dest, src+((y&63)<<6), SCREENWIDTH&63);
-	    dest += (SCREENWIDTH&63);
+	    *dest = src[(((y >> hires) & 63) << 6) + ((x >> hires) & 63)];
+	    dest += SCREENXSTEP;
 	}
     }
 
-    V_MarkRect (0, 0, SCREENWIDTH, SCREENHEIGHT);
+    V_MarkRect (0, 0, ORIGWIDTH, ORIGHEIGHT);
     
     // draw some of the text onto the screen
     cx = 10;
@@ -284,7 +280,7 @@ void F_TextWrite (void)
 	}
 		
 	w = SHORT (hu_font[c]->width);
-	if (cx+w > SCREENWIDTH)
+	if (cx+w > ORIGWIDTH)
 	    break;
 	V_DrawPatch(cx, cy, hu_font[c]);
 	cx+=w;
@@ -567,6 +563,8 @@ void F_CastDrawer (void)
 
 //
 // F_DrawPatchCol
+// Draws patch column col at 320x200 column x,
+//  repeated across 1 << hires framebuffer columns.
 //
 void
 F_DrawPatchCol
@@ -579,23 +577,29 @@ F_DrawPatchCol
     byte*	dest;
     byte*	desttop;
     int		count;
+    int		row;
+    int		i;
 	
-    column = (column_t *)((byte *)patch + LONG(patch->columnofs[col]));
-    desttop = I_VideoBuffer + x;
-
-    // step through the posts in a column
-    while (column->topdelta != 0xff )
+    for (i=0 ; i < (1 << hires) ; i++)
     {
-	source = (byte *)column + 3;
-	dest = desttop + column->topdelta*SCREENWIDTH;
-	count = column->length;
-		
-	while (count--)
+	column = (column_t *)((byte *)patch + LONG(patch->columnofs[col]));
+	desttop = I_VideoBuffer + SCREENOFS((x << hires) + i, 0);
+
+	// step through the posts in a column
+	while (column->topdelta != 0xff )
 	{
-	    *dest = *source++;
-	    dest += SCREENWIDTH;
+	    source = (byte *)column + 3;
+	    dest = desttop + SCREENOFS(0, column->topdelta << hires);
+	    count = column->length << hires;
+	    row = 0;
+
+	    while (count--)
+	    {
+		*dest = source[row++ >> hires];
+		dest += SCREENYSTEP;
+	    }
+	    column = (column_t *)(  (byte *)column + column->length + 4 );
 	}
-	column = (column_t *)(  (byte *)column + column->length + 4 );
     }
 }
 
@@ -616,7 +620,7 @@ void F_BunnyScroll (void)
     p1 = W_CacheLumpName (DEH_String("PFUB2"), PU_LEVEL);
     p2 = W_CacheLumpName (DEH_String("PFUB1"), PU_LEVEL);
 
-    V_MarkRect (0, 0, SCREENWIDTH, SCREENHEIGHT);
+    V_MarkRect (0, 0, ORIGWIDTH, ORIGHEIGHT);
 	
     scrolled = (320 - ((signed int) finalecount-230)/2);
     if (scrolled > 320)
@@ -624,7 +628,7 @@ void F_BunnyScroll (void)
     if (scrolled < 0)
 	scrolled = 0;
 		
-    for ( x=0 ; x<SCREENWIDTH ; x++)
+    for ( x=0 ; x<ORIGWIDTH ; x++)
     {
 	if (x+scrolled < 320)
 	    F_DrawPatchCol (x, p1, x+scrolled);
@@ -636,8 +640,8 @@ void F_BunnyScroll (void)
 	return;
     if (finalecount < 1180)
     {
-        V_DrawPatch((SCREENWIDTH - 13 * 8) / 2,
-                    (SCREENHEIGHT - 8 * 8) / 2, 
+        V_DrawPatch((ORIGWIDTH - 13 * 8) / 2,
+                    (ORIGHEIGHT - 8 * 8) / 2, 
                     W_CacheLumpName(DEH_String("END0"), PU_CACHE));
 	laststage = 0;
 	return;
@@ -653,8 +657,8 @@ void F_BunnyScroll (void)
     }
 	
     DEH_snprintf(name, 10, "END%i", stage);
-    V_DrawPatch((SCREENWIDTH - 13 * 8) / 2, 
-                (SCREENHEIGHT - 8 * 8) / 2, 
+    V_DrawPatch((ORIGWIDTH - 13 * 8) / 2, 
+                (ORIGHEIGHT - 8 * 8) / 2, 
                 W_CacheLumpName (name,PU_CACHE));
 }
 
@@ -140,10 +140,12 @@ wipe_initMelt
     // copy start screen to main screen
     memcpy(wipe_scr, wipe_scr_start, width*height);
     
+#ifndef COLUMN_MAJOR_VIDEO
     // makes this wipe faster (in theory)
     // to have stuff in column-major format
     wipe_shittyColMajorXform((short*)wipe_scr_start, width/2, height);
     wipe_shittyColMajorXform((short*)wipe_scr_end, width/2, height);
+#endif
     
     // setup initial column positions
     // (y<0 => not ready to scroll yet)
@@ -169,10 +171,12 @@ wipe_doMelt
     int		i;
     int		j;
     int		dy;
+#ifndef COLUMN_MAJOR_VIDEO
     int		idx;
     
     short*	s;
     short*	d;
+#endif
     boolean	done = true;
 
     width/=2;
@@ -187,8 +191,20 @@ wipe_doMelt
 	    }
 	    else if (y[i] < height)
 	    {
-		dy = (y[i] < 16) ? y[i]+1 : 8;
+		dy = (y[i] < (16 << hires)) ? y[i]+1 : (8 << hires);
 		if (y[i]+dy >= height) dy = height - y[i];
+#ifdef COLUMN_MAJOR_VIDEO
+		// The screens are already column-major, a byte per
+		// pixel: move both pixel columns of this strip.
+		for (j=i*2 ; j<i*2+2 ; j++)
+		{
+		    memcpy(wipe_scr + j*height + y[i],
+			   wipe_scr_end + j*height + y[i], dy);
+		    memcpy(wipe_scr + j*height + y[i] + dy,
+			   wipe_scr_start + j*height, height - y[i] - dy);
+		}
+		y[i] += dy;
+#else
 		s = &((short *)wipe_scr_end)[i*height+y[i]];
 		d = &((short *)wipe_scr)[y[i]*width+i];
 		idx = 0;
@@ -206,6 +222,7 @@ wipe_doMelt
 		    d[idx] = *(s++);
 		    idx += width;
 		}
+#endif
 		done = false;
 	    }
 	}
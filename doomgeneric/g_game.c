@@ -595,6 +595,67 @@ void G_BuildTiccmd (ticcmd_t* cmd, int maketic)
         carry = desired_angleturn - cmd->angleturn;
     }
 } 
+
+
+//
+// G_LocalTurn
+// For drawing the view of the console player ahead of the tics.
+// Sets turn to how far the input held now turns the player frac
+// of the way into the next tic, as G_BuildTiccmd and P_MovePlayer
+// would.  Returns false if the player cannot turn by input now.
+//
+boolean G_LocalTurn (fixed_t frac, angle_t* turn)
+{
+    player_t*	player;
+    boolean	strafe;
+    boolean	speed;
+    int		tspeed;
+    int		delta;
+
+    player = &players[consoleplayer];
+
+    if (gamestate != GS_LEVEL || demoplayback || paused || menuactive
+     || displayplayer != consoleplayer
+     || player->playerstate != PST_LIVE
+     || player->mo->reactiontime
+     || (player->mo->flags & MF_JUSTATTACKED))
+    {
+	return false;
+    }
+
+    strafe = gamekeydown[key_strafe] || mousebuttons[mousebstrafe]
+	|| joybuttons[joybstrafe];
+
+    speed = key_speed >= NUMKEYS
+         || joybspeed >= MAX_JOY_BUTTONS
+         || gamekeydown[key_speed]
+         || joybuttons[joybspeed];
+
+    if (turnheld + ticdup < SLOWTURNTICS)
+	tspeed = 2;
+    else
+	tspeed = speed;
+
+    delta = 0;
+
+    if (!strafe)
+    {
+	if (gamekeydown[key_right])
+	    delta -= angleturn[tspeed];
+	if (gamekeydown[key_left])
+	    delta += angleturn[tspeed];
+	if (joyxmove > 0)
+	    delta -= angleturn[tspeed];
+	if (joyxmove < 0)
+	    delta += angleturn[tspeed];
+
+	delta = FixedMul (delta, frac) - mousex*0x8;
+    }
+
+    *turn = (angle_t) delta << FRACBITS;
+
+    return true;
+}
  
 
 //
@@ -23,6 +23,7 @@
 #include "doomdef.h"
 #include "d_event.h"
 #include "d_ticcmd.h"
+#include "tables.h"
 
 
 //
@@ -66,6 +67,9 @@ void G_WorldDone (void);
 
 void G_BuildTiccmd (ticcmd_t *cmd, int maketic); 
 
+// How far the input held now turns the console player.
+boolean G_LocalTurn (fixed_t frac, angle_t *turn);
+
 void G_Ticker (void);
 boolean G_Responder (event_t*	ev);
 
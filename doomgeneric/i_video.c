@@ -96,6 +96,11 @@ void I_GetEvent(void);
 
 byte *I_VideoBuffer = NULL;
 
+// Render resolution: SCREENWIDTH x SCREENHEIGHT is the original
+// 320x200 shifted left by this.
+
+int hires = 0;
+
 // If true, game is running as a screensaver
 
 boolean screensaver_mode = false;
@@ -202,6 +207,69 @@ void cmap_to_fb(uint8_t *out, uint8_t *in, int in_pixels)
     }
 }
 
+//
+// I_InitScreenScale
+// Picks the render resolution. Must run before anything
+// allocates buffers or tables sized by SCREENWIDTH/SCREENHEIGHT.
+//
+void I_InitScreenScale (void)
+{
+    int p;
+    int scale;
+
+    //!
+    // @arg <n>
+    // @category video
+    //
+    // Render at n times the original 320x200 resolution instead of
+    // scaling the finished frame up. n may be 1, 2 or 4; 0 picks the
+    // largest that fits the framebuffer. The default is 1.
+    //
+
+    p = M_CheckParmWithArgs("-renderscale", 1);
+
+    if (p == 0)
+    {
+        return;
+    }
+
+    scale = atoi(myargv[p + 1]);
+
+    if (scale == 0)
+    {
+        for (hires = MAXHIRES; hires > 0; --hires)
+        {
+            if (SCREENWIDTH <= DOOMGENERIC_RESX
+             && SCREENHEIGHT <= DOOMGENERIC_RESY)
+            {
+                break;
+            }
+        }
+    }
+    else
+    {
+        while (hires < MAXHIRES && (1 << hires) < scale)
+        {
+            ++hires;
+        }
+
+        if ((1 << hires) != scale)
+        {
+            I_Error("I_InitScreenScale: invalid -renderscale %i", scale);
+        }
+
+        if (SCREENWIDTH > DOOMGENERIC_RESX || SCREENHEIGHT > DOOMGENERIC_RESY)
+        {
+            I_Error("I_InitScreenScale: %ix%i does not fit the %ix%i "
+                    "framebuffer", SCREENWIDTH, SCREENHEIGHT,
+                    DOOMGENERIC_RESX, DOOMGENERIC_RESY);
+        }
+    }
+
+    printf("I_InitScreenScale: rendering at %ix%i\n",
+           SCREENWIDTH, SCREENHEIGHT);
+}
+
 void I_InitGraphics (void)
 {
     int i, gfxmodeparm;
@@ -314,6 +382,55 @@ void I_UpdateNoBlit (void)
 {
 }
 
+#ifdef COLUMN_MAJOR_VIDEO
+
+// Row-major copy of I_VideoBuffer for the present loop below.
+static byte *transposed_buffer = NULL;
+
+// Both screen dimensions are multiples of this at every scale.
+#define TRANSPOSE_TILE 8
+
+//
+// I_TransposeScreen
+// Copies the column-major screen into rows one tile at
+// a time, so that reads and writes both stay in cache.
+//
+static byte *I_TransposeScreen (void)
+{
+    int tx, ty;
+    int x, y;
+    byte *src;
+    byte *dest;
+
+    if (transposed_buffer == NULL)
+    {
+        transposed_buffer = Z_Malloc(SCREENWIDTH * SCREENHEIGHT,
+                                     PU_STATIC, NULL);
+    }
+
+    for (ty = 0; ty < SCREENHEIGHT; ty += TRANSPOSE_TILE)
+    {
+        for (tx = 0; tx < SCREENWIDTH; tx += TRANSPOSE_TILE)
+        {
+            for (x = tx; x < tx + TRANSPOSE_TILE; x++)
+            {
+                src = I_VideoBuffer + SCREENOFS(x, ty);
+                dest = transposed_buffer + ty * SCREENWIDTH + x;
+
+                for (y = 0; y < TRANSPOSE_TILE; y++)
+                {
+                    *dest = *src++;
+                    dest += SCREENWIDTH;
+                }
+            }
+        }
+    }
+
+    return transposed_buffer;
+}
+
+#endif
+
 //
 // I_FinishUpdate
 //
@@ -334,7 +451,11 @@ void I_FinishUpdate (void)
     x_offset_end = ((s_Fb.xres - (SCREENWIDTH  * fb_scaling)) * s_Fb.bits_per_pixel/8) - x_offset;
 
     /* DRAW SCREEN */
+#ifdef COLUMN_MAJOR_VIDEO
+    line_in  = (unsigned char *) I_TransposeScreen();
+#else
     line_in  = (unsigned char *) I_VideoBuffer;
+#endif
     line_out = (unsigned char *) DG_ScreenBuffer;
 
     y = SCREENHEIGHT;
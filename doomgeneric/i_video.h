@@ -22,10 +22,34 @@
 
 #include "doomtype.h"
 
-// Screen width and height.
+// Screen width and height of the original game. Menus, status bar,
+// intermission and finale are laid out in these coordinates.
 
-#define SCREENWIDTH  320
-#define SCREENHEIGHT 200
+#define ORIGWIDTH  320
+#define ORIGHEIGHT 200
+
+// Screen width and height actually rendered: the original size times
+// 1 << hires, picked at startup by I_InitScreenScale.
+
+#define MAXHIRES 2
+
+#define SCREENWIDTH  (ORIGWIDTH << hires)
+#define SCREENHEIGHT (ORIGHEIGHT << hires)
+
+// Layout of I_VideoBuffer and the other screen sized buffers.
+// Building with COLUMN_MAJOR_VIDEO stores the screen a column at
+// a time, so the wall and sprite drawers write sequentially and
+// I_FinishUpdate transposes the frame when presenting it.
+
+#ifdef COLUMN_MAJOR_VIDEO
+#define SCREENXSTEP  SCREENHEIGHT
+#define SCREENYSTEP  1
+#else
+#define SCREENXSTEP  1
+#define SCREENYSTEP  SCREENWIDTH
+#endif
+
+#define SCREENOFS(x, y) ((x) * SCREENXSTEP + (y) * SCREENYSTEP)
 
 // Screen width used for "squash" scale functions
 
@@ -91,6 +115,9 @@ typedef struct
 
 typedef boolean (*grabmouse_callback_t)(void);
 
+// Called by D_DoomMain before anything is sized to the screen.
+void I_InitScreenScale (void);
+
 // Called by D_DoomMain,
 // determines the hardware configuration
 // and sets up the video mode
@@ -155,6 +182,7 @@ extern int vanilla_keyboard_mapping;
 extern boolean screensaver_mode;
 extern int usegamma;
 extern byte *I_VideoBuffer;
+extern int hires;
 
 extern int screen_width;
 extern int screen_height;
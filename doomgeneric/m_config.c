@@ -855,6 +855,58 @@ static default_t extra_defaults_list[] =
 
     CONFIG_VARIABLE_INT(vanilla_demo_limit),
 
+    //!
+    // @game doom
+    //
+    // If non-zero, the Vanilla renderer limits are enforced: walls
+    // past the 256th drawseg are dropped and running out of openings
+    // or clip ranges is an error.  If this has a value of zero, these
+    // arrays grow as needed so large maps render fully.
+    //
+
+    CONFIG_VARIABLE_INT(vanilla_render_limit),
+
+    //!
+    // @game doom
+    //
+    // Frame time budget in milliseconds.  If non-zero, the renderer
+    // drops to low detail and then shrinks the view while frames take
+    // longer than this, and restores the player's settings once they
+    // are comfortably under it again.
+    //
+
+    CONFIG_VARIABLE_INT(render_frame_budget),
+
+    //!
+    // @game doom
+    //
+    // Number of threads drawing the player view.  Each draws a
+    // vertical strip of it; 1 draws it all on the main thread.
+    //
+
+    CONFIG_VARIABLE_INT(render_threads),
+
+    //!
+    // @game doom
+    //
+    // Most frames in a row left undrawn while the game is running
+    // behind the clock, so that it can catch up.  0 draws every
+    // frame.
+    //
+
+    CONFIG_VARIABLE_INT(render_frame_skip),
+
+    //!
+    // @game doom
+    //
+    // If non-zero, frames are drawn in between the 35 tics a
+    // second, at most this many a second, with everything moved
+    // part of the way to where the next tic puts it.  0 draws one
+    // frame a tic.
+    //
+
+    CONFIG_VARIABLE_INT(uncapped_framerate),
+
     //!
     // If non-zero, the game behaves like Vanilla Doom, always assuming
     // an American keyboard mapping.  If this has a value of zero, the
@@ -18,6 +18,9 @@
 
 
 
+#include <stdio.h>
+#include <time.h>
+
 #include "stdlib.h"
 
 #include "doomtype.h"
@@ -27,36 +30,205 @@
 
 
 
+//
+// M_FixedCheck
+//
+// FixedMul and FixedDiv live in m_fixed.h.  What remains here checks
+// the floating point division path against the 64-bit integer one.
+// The double path is tested on every build, so the reasoning holds up
+// on hosts as well as on ARM.
+//
 
-// Fixme. __USE_C_FIXED__ or something.
+static fixed_t FixedDivInt64 (fixed_t a, fixed_t b)
+{
+    if ((abs(a) >> 14) >= abs(b))
+    {
+	return (a^b) < 0 ? INT_MIN : INT_MAX;
+    }
 
-fixed_t
-FixedMul
-( fixed_t	a,
-  fixed_t	b )
+    return (fixed_t) (((int64_t) a << 16) / b);
+}
+
+static fixed_t FixedDivDouble (fixed_t a, fixed_t b)
 {
-    return ((int64_t) a * (int64_t) b) >> FRACBITS;
+    if ((abs(a) >> 14) >= abs(b))
+    {
+	return (a^b) < 0 ? INT_MIN : INT_MAX;
+    }
+
+    return (fixed_t) (((double) a * FRACUNIT) / (double) b);
 }
 
+static unsigned int checkseed = 1;
+static int checkcount;
 
+static unsigned int CheckRandom (void)
+{
+    // xorshift32
+    checkseed ^= checkseed << 13;
+    checkseed ^= checkseed >> 17;
+    checkseed ^= checkseed << 5;
 
-//
-// FixedDiv, C version.
-//
+    return checkseed;
+}
+
+// Random value with a random magnitude, so that small and large
+// operands are covered equally.
 
-fixed_t FixedDiv(fixed_t a, fixed_t b)
+static fixed_t CheckOperand (void)
 {
-    if ((abs(a) >> 14) >= abs(b))
+    unsigned int r;
+
+    r = CheckRandom() >> (CheckRandom() & 31);
+
+    return (CheckRandom() & 1) ? -(fixed_t) (r >> 1) : (fixed_t) (r >> 1);
+}
+
+static void CheckPair (fixed_t a, fixed_t b)
+{
+    fixed_t expected;
+
+    if (b == 0 || a == INT_MIN || b == INT_MIN)
     {
-	return (a^b) < 0 ? INT_MIN : INT_MAX;
+	return;
     }
-    else
+
+    expected = FixedDivInt64(a, b);
+    ++checkcount;
+
+    if (FixedDivDouble(a, b) != expected || FixedDiv(a, b) != expected)
     {
-	int64_t result;
+	I_Error("M_FixedCheck: FixedDiv(%i, %i) = %i/%i, expected %i",
+		a, b, FixedDivDouble(a, b), FixedDiv(a, b), expected);
+    }
+}
 
-	result = ((int64_t) a << 16) / b;
+#define BENCH_PAIRS	4096
+#define BENCH_ROUNDS	2000
 
-	return (fixed_t) result;
+static double BenchDiv (fixed_t (*div)(fixed_t, fixed_t),
+			fixed_t *a, fixed_t *b, fixed_t *sum)
+{
+    clock_t start;
+    unsigned int total;
+    int i, j;
+
+    total = 0;
+    start = clock();
+
+    for (j = 0; j < BENCH_ROUNDS; ++j)
+    {
+	for (i = 0; i < BENCH_PAIRS; ++i)
+	{
+	    total += (unsigned int) div(a[i], b[i]);
+	}
     }
+
+    *sum ^= (fixed_t) total;
+
+    return (double) (clock() - start) * 1e9
+	 / CLOCKS_PER_SEC / ((double) BENCH_ROUNDS * BENCH_PAIRS);
+}
+
+static fixed_t FixedDivInline (fixed_t a, fixed_t b)
+{
+    return FixedDiv(a, b);
 }
 
+void M_FixedCheck (void)
+{
+    static const fixed_t edges[] =
+    {
+	0, 1, 2, 3, 255, 256, 16383, 16384, 16385, 32767, 32768,
+	FRACUNIT - 1, FRACUNIT, FRACUNIT + 1, 0x7fff, 0x8000, 0xffffff,
+	0x1000000, 0x3fffffff, 0x40000000, INT_MAX - 1, INT_MAX,
+    };
+    fixed_t *bencha, *benchb;
+    fixed_t sum;
+    double t_int64, t_double, t_inline;
+    int a, b;
+    int i, j;
+
+    checkcount = 0;
+
+    // Every pair of small operands.
+
+    for (a = -2048; a <= 2048; ++a)
+    {
+	for (b = -2048; b <= 2048; ++b)
+	{
+	    CheckPair(a, b);
+	}
+    }
+
+    // Both sides of the overflow test, and quotients just under
+    // and over each integer, for every divisor up to 2^17.
+
+    for (b = 1; b <= 1 << 17; ++b)
+    {
+	for (i = -1; i <= 1; ++i)
+	{
+	    if (b < (1 << 17))
+	    {
+		CheckPair((b << 14) + i, b);
+		CheckPair(-((b << 14) + i), b);
+	    }
+
+	    CheckPair(b + i, b);
+	    CheckPair(INT_MAX / FRACUNIT - i, b);
+	    CheckPair(-(b * 3 + i), -b);
+	}
+    }
+
+    // The edge values against each other, in all sign combinations.
+
+    for (i = 0; i < arrlen(edges); ++i)
+    {
+	for (j = 0; j < arrlen(edges); ++j)
+	{
+	    CheckPair(edges[i], edges[j]);
+	    CheckPair(-edges[i], edges[j]);
+	    CheckPair(edges[i], -edges[j]);
+	    CheckPair(-edges[i], -edges[j]);
+	}
+    }
+
+    // Random operands.
+
+    for (i = 0; i < 1 << 24; ++i)
+    {
+	CheckPair(CheckOperand(), CheckOperand());
+    }
+
+    printf("M_FixedCheck: %i divisions match the 64-bit reference\n",
+	   checkcount);
+
+    // Time the reference, the double path and the inline FixedDiv
+    // on the same operands.  Divisors stay well away from overflow.
+
+    bencha = malloc(BENCH_PAIRS * sizeof(*bencha));
+    benchb = malloc(BENCH_PAIRS * sizeof(*benchb));
+
+    if (bencha == NULL || benchb == NULL)
+    {
+	I_Error("M_FixedCheck: out of memory");
+    }
+
+    for (i = 0; i < BENCH_PAIRS; ++i)
+    {
+	bencha[i] = CheckOperand() >> 8;
+	benchb[i] = (CheckOperand() | FRACUNIT) >> 4;
+    }
+
+    sum = 0;
+    t_int64 = BenchDiv(FixedDivInt64, bencha, benchb, &sum);
+    t_double = BenchDiv(FixedDivDouble, bencha, benchb, &sum);
+    t_inline = BenchDiv(FixedDivInline, bencha, benchb, &sum);
+
+    printf("M_FixedCheck: int64 %.1f ns, double %.1f ns, "
+	   "FixedDiv %.1f ns per call (%i)\n",
+	   t_int64, t_double, t_inline, sum);
+
+    free(bencha);
+    free(benchb);
+}
@@ -20,7 +20,9 @@
 #ifndef __M_FIXED__
 #define __M_FIXED__
 
+#include <stdlib.h>
 
+#include "doomtype.h"
 
 
 //
@@ -31,8 +33,44 @@
 
 typedef int fixed_t;
 
-fixed_t FixedMul	(fixed_t a, fixed_t b);
-fixed_t FixedDiv	(fixed_t a, fixed_t b);
+// With hardware double precision (ARM VFP), FixedDiv divides in
+// floating point instead of calling the 64-bit library division.
+// Both operands are exact as doubles, and since |a << 16| < 2^47 the
+// rounded quotient never crosses an integer, so the truncated result
+// is the same.  M_FixedCheck tests this.
+
+#if defined(__arm__) && defined(__ARM_FP) && (__ARM_FP & 8)
+#define FIXEDDIV_VFP
+#endif
+
+//
+// FixedMul, FixedDiv
+// Inline, as they run for every column, sprite and
+//  collision check and not every build has LTO.
+//
+
+static inline fixed_t FixedMul (fixed_t a, fixed_t b)
+{
+    return ((int64_t) a * (int64_t) b) >> FRACBITS;
+}
+
+static inline fixed_t FixedDiv (fixed_t a, fixed_t b)
+{
+    if ((abs(a) >> 14) >= abs(b))
+    {
+	return (a^b) < 0 ? INT_MIN : INT_MAX;
+    }
+
+#ifdef FIXEDDIV_VFP
+    return (fixed_t) (((double) a * FRACUNIT) / (double) b);
+#else
+    return (fixed_t) (((int64_t) a << 16) / b);
+#endif
+}
+
+// Compares FixedDiv with the 64-bit integer division for a sweep of
+// inputs and times both.  Called by D_DoomMain for -fixedcheck.
+void M_FixedCheck (void);
 
 
 
@@ -20,6 +20,8 @@
 
 
 #include <math.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "z_zone.h"
 
@@ -31,6 +33,12 @@
 #include "g_game.h"
 
 #include "i_system.h"
+#include "i_timer.h"
+#include "m_config.h"
+#include "m_misc.h"
+#include "sha1.h"
+#include "w_checksum.h"
+#include "w_prefetch.h"
 #include "w_wad.h"
 
 #include "doomdef.h"
@@ -62,6 +70,8 @@ subsector_t*	subsectors;
 
 int		numnodes;
 node_t*		nodes;
+nodebox_t*	nodeboxes;
+int*		bspstack;
 
 int		numlines;
 line_t*		lines;
@@ -70,6 +80,7 @@ int		numsides;
 side_t*		sides;
 
 static int      totallines;
+static line_t**	linebuffer;	// the sectors' lines lists
 
 // BLOCKMAP
 // Created from axis aligned bounding box
@@ -109,6 +120,104 @@ mapthing_t*	deathmatch_p;
 mapthing_t	playerstarts[MAXPLAYERS];
 
 
+// LEVEL ARENA
+// One block holding the tables loaded for the level, one after
+//  another in the order they are loaded. Sized from the lengths
+//  of the level's lumps, and freed in one Z_Free at level exit.
+//
+#define LEVELALIGN(x)	(((x) + sizeof(void *) - 1) & ~(sizeof(void *) - 1))
+
+static byte*	levelarena;
+static int	levelarenasize;
+static int	levelarenaused;
+static boolean	levelarenaoverflow;
+
+
+//
+// P_LevelArenaSize
+// Bytes the level arena needs for the level at lumpnum.
+// Upper bounds stand in where the count comes from another
+//  lump's contents.
+//
+static int P_LevelArenaSize (int lumpnum)
+{
+    int		blockmaplen;
+    int		numlinedefs;
+    int		numsecs;
+    int		nodecount;
+    int		rejectlen;
+    int		size;
+
+    blockmaplen = W_LumpLength (lumpnum+ML_BLOCKMAP);
+    numlinedefs = W_LumpLength (lumpnum+ML_LINEDEFS) / sizeof(maplinedef_t);
+    numsecs = W_LumpLength (lumpnum+ML_SECTORS) / sizeof(mapsector_t);
+    nodecount = W_LumpLength (lumpnum+ML_NODES) / sizeof(mapnode_t);
+
+    rejectlen = W_LumpLength (lumpnum+ML_REJECT);
+
+    if (rejectlen < (numsecs * numsecs + 7) / 8)
+	rejectlen = (numsecs * numsecs + 7) / 8;
+
+    size = LEVELALIGN(blockmaplen);
+
+    // the blockmap's offset table has a short for each block
+    size += LEVELALIGN(blockmaplen / 2 * sizeof(*blocklinks));
+
+    size += LEVELALIGN(W_LumpLength (lumpnum+ML_VERTEXES)
+		       / sizeof(mapvertex_t) * sizeof(vertex_t));
+    size += LEVELALIGN(numsecs * sizeof(sector_t));
+    size += LEVELALIGN(W_LumpLength (lumpnum+ML_SIDEDEFS)
+		       / sizeof(mapsidedef_t) * sizeof(side_t));
+    size += LEVELALIGN(numlinedefs * sizeof(line_t));
+    size += LEVELALIGN(W_LumpLength (lumpnum+ML_SSECTORS)
+		       / sizeof(mapsubsector_t) * sizeof(subsector_t));
+    size += LEVELALIGN(nodecount * sizeof(node_t));
+    size += LEVELALIGN(nodecount * sizeof(nodebox_t));
+    size += LEVELALIGN(nodecount * sizeof(*bspstack));
+    size += LEVELALIGN(W_LumpLength (lumpnum+ML_SEGS)
+		       / sizeof(mapseg_t) * sizeof(seg_t));
+
+    // each line is in the list of at most two sectors
+    size += LEVELALIGN(2 * numlinedefs * sizeof(line_t *));
+
+    size += LEVELALIGN(rejectlen);
+
+    return size;
+}
+
+
+//
+// P_LevelAlloc
+// Takes size bytes for the level from the level arena. Should the
+//  bounds above be wrong, the table is a block of its own.
+//
+static void* P_LevelAlloc (int size)
+{
+    void*	result;
+
+    if (levelarenaused + LEVELALIGN(size) > levelarenasize)
+    {
+	levelarenaoverflow = true;
+	return Z_Malloc (size, PU_LEVEL, 0);
+    }
+
+    result = levelarena + levelarenaused;
+    levelarenaused += LEVELALIGN(size);
+
+    return result;
+}
+
+
+//
+// P_FreeLevelArena
+//
+static void P_FreeLevelArena (void)
+{
+    if (levelarena == NULL)
+	return;
+
+    Z_Free (levelarena);
+}
 
 
 
@@ -127,7 +236,7 @@ void P_LoadVertexes (int lump)
     numvertexes = W_LumpLength (lump) / sizeof(mapvertex_t);
 
     // Allocate zone memory for buffer.
-    vertexes = Z_Malloc (numvertexes*sizeof(vertex_t),PU_LEVEL,0);	
+    vertexes = P_LevelAlloc (numvertexes*sizeof(vertex_t));	
 
     // Load data into cache.
     data = W_CacheLumpNum (lump, PU_STATIC);
@@ -181,7 +290,7 @@ void P_LoadSegs (int lump)
     int                 sidenum;
 	
     numsegs = W_LumpLength (lump) / sizeof(mapseg_t);
-    segs = Z_Malloc (numsegs*sizeof(seg_t),PU_LEVEL,0);	
+    segs = P_LevelAlloc (numsegs*sizeof(seg_t));	
     memset (segs, 0, numsegs*sizeof(seg_t));
     data = W_CacheLumpNum (lump,PU_STATIC);
 	
@@ -241,7 +350,7 @@ void P_LoadSubsectors (int lump)
     subsector_t*	ss;
 	
     numsubsectors = W_LumpLength (lump) / sizeof(mapsubsector_t);
-    subsectors = Z_Malloc (numsubsectors*sizeof(subsector_t),PU_LEVEL,0);	
+    subsectors = P_LevelAlloc (numsubsectors*sizeof(subsector_t));	
     data = W_CacheLumpNum (lump,PU_STATIC);
 	
     ms = (mapsubsector_t *)data;
@@ -270,7 +379,7 @@ void P_LoadSectors (int lump)
     sector_t*		ss;
 	
     numsectors = W_LumpLength (lump) / sizeof(mapsector_t);
-    sectors = Z_Malloc (numsectors*sizeof(sector_t),PU_LEVEL,0);	
+    sectors = P_LevelAlloc (numsectors*sizeof(sector_t));	
     memset (sectors, 0, numsectors*sizeof(sector_t));
     data = W_CacheLumpNum (lump,PU_STATIC);
 	
@@ -292,6 +401,39 @@ void P_LoadSectors (int lump)
 }
 
 
+//
+// P_NumberNodes
+// Numbers the nodes under bspnum in the order a walk of the tree
+// finishes them, so that every subtree takes one contiguous run
+// of the node table, ending with its own root.
+//
+static void
+P_NumberNodes
+( mapnode_t*	mapnodes,
+  int		bspnum,
+  int*		newnum,
+  int*		next )
+{
+    int		j;
+
+    if ((bspnum & NF_SUBSECTOR) || bspnum >= numnodes
+     || newnum[bspnum] != -1)
+	return;
+
+    // Mark it, in case a broken tree leads back here.
+    newnum[bspnum] = -2;
+
+    for (j=0 ; j<2 ; j++)
+    {
+	P_NumberNodes (mapnodes,
+		       (unsigned short) SHORT(mapnodes[bspnum].children[j]),
+		       newnum, next);
+    }
+
+    newnum[bspnum] = (*next)++;
+}
+
+
 //
 // P_LoadNodes
 //
@@ -301,30 +443,63 @@ void P_LoadNodes (int lump)
     int		i;
     int		j;
     int		k;
+    int		walked;
+    int		unwalked;
+    int		child;
+    int*	newnum;
     mapnode_t*	mn;
     node_t*	no;
+    nodebox_t*	nb;
 	
     numnodes = W_LumpLength (lump) / sizeof(mapnode_t);
-    nodes = Z_Malloc (numnodes*sizeof(node_t),PU_LEVEL,0);	
+    nodes = P_LevelAlloc (numnodes*sizeof(node_t));
+    nodeboxes = P_LevelAlloc (numnodes*sizeof(nodebox_t));
+    bspstack = P_LevelAlloc (numnodes*sizeof(*bspstack));
+    newnum = Z_Malloc (numnodes*sizeof(*newnum),PU_STATIC,0);
     data = W_CacheLumpNum (lump,PU_STATIC);
 	
     mn = (mapnode_t *)data;
-    no = nodes;
+
+    // Renumber the tree from its root. The root stays the last
+    // node; any nodes it cannot reach go in front of the rest.
+    for (i=0 ; i<numnodes ; i++)
+	newnum[i] = -1;
+
+    walked = 0;
+    P_NumberNodes (mn, numnodes-1, newnum, &walked);
+    unwalked = 0;
+
+    for (i=0 ; i<numnodes ; i++)
+    {
+	if (newnum[i] < 0)
+	    newnum[i] = unwalked++;
+	else
+	    newnum[i] += numnodes - walked;
+    }
     
-    for (i=0 ; i<numnodes ; i++, no++, mn++)
+    for (i=0 ; i<numnodes ; i++, mn++)
     {
-	no->x = SHORT(mn->x)<<FRACBITS;
-	no->y = SHORT(mn->y)<<FRACBITS;
-	no->dx = SHORT(mn->dx)<<FRACBITS;
-	no->dy = SHORT(mn->dy)<<FRACBITS;
+	no = &nodes[newnum[i]];
+	nb = &nodeboxes[newnum[i]];
+
+	no->x = SHORT(mn->x);
+	no->y = SHORT(mn->y);
+	no->dx = SHORT(mn->dx);
+	no->dy = SHORT(mn->dy);
 	for (j=0 ; j<2 ; j++)
 	{
-	    no->children[j] = SHORT(mn->children[j]);
+	    child = (unsigned short) SHORT(mn->children[j]);
+
+	    if (!(child & NF_SUBSECTOR) && child < numnodes)
+		child = newnum[child];
+
+	    no->children[j] = child;
 	    for (k=0 ; k<4 ; k++)
-		no->bbox[j][k] = SHORT(mn->bbox[j][k])<<FRACBITS;
+		nb->bbox[j][k] = SHORT(mn->bbox[j][k]);
 	}
     }
 	
+    Z_Free (newnum);
     W_ReleaseLumpNum(lump);
 }
 
@@ -399,7 +574,7 @@ void P_LoadLineDefs (int lump)
     vertex_t*		v2;
 	
     numlines = W_LumpLength (lump) / sizeof(maplinedef_t);
-    lines = Z_Malloc (numlines*sizeof(line_t),PU_LEVEL,0);	
+    lines = P_LevelAlloc (numlines*sizeof(line_t));	
     memset (lines, 0, numlines*sizeof(line_t));
     data = W_CacheLumpNum (lump,PU_STATIC);
 	
@@ -478,7 +653,7 @@ void P_LoadSideDefs (int lump)
     side_t*		sd;
 	
     numsides = W_LumpLength (lump) / sizeof(mapsidedef_t);
-    sides = Z_Malloc (numsides*sizeof(side_t),PU_LEVEL,0);	
+    sides = P_LevelAlloc (numsides*sizeof(side_t));	
     memset (sides, 0, numsides*sizeof(side_t));
     data = W_CacheLumpNum (lump,PU_STATIC);
 	
@@ -510,7 +685,7 @@ void P_LoadBlockMap (int lump)
     lumplen = W_LumpLength(lump);
     count = lumplen / 2;
 	
-    blockmaplump = Z_Malloc(lumplen, PU_LEVEL, NULL);
+    blockmaplump = P_LevelAlloc(lumplen);
     W_ReadLump(lump, blockmaplump);
     blockmap = blockmaplump + 4;
 
@@ -531,7 +706,7 @@ void P_LoadBlockMap (int lump)
     // Clear out mobj chains
 
     count = sizeof(*blocklinks) * bmapwidth * bmapheight;
-    blocklinks = Z_Malloc(count, PU_LEVEL, 0);
+    blocklinks = P_LevelAlloc(count);
     memset(blocklinks, 0, count);
 }
 
@@ -544,7 +719,7 @@ void P_LoadBlockMap (int lump)
 //
 void P_GroupLines (void)
 {
-    line_t**		linebuffer;
+    line_t**		buffer;
     int			i;
     int			j;
     line_t*		li;
@@ -578,14 +753,15 @@ void P_GroupLines (void)
     }
 
     // build line tables for each sector	
-    linebuffer = Z_Malloc (totallines*sizeof(line_t *), PU_LEVEL, 0);
+    linebuffer = P_LevelAlloc (totallines*sizeof(line_t *));
+    buffer = linebuffer;
 
     for (i=0; i<numsectors; ++i)
     {
         // Assign the line buffer for this sector
 
-        sectors[i].lines = linebuffer;
-        linebuffer += sectors[i].linecount;
+        sectors[i].lines = buffer;
+        buffer += sectors[i].linecount;
 
         // Reset linecount to zero so in the next stage we can count
         // lines into the list.
@@ -726,17 +902,684 @@ static void P_LoadReject(int lumpnum)
 
     if (lumplen >= minlength)
     {
-        rejectmatrix = W_CacheLumpNum(lumpnum, PU_LEVEL);
+        rejectmatrix = P_LevelAlloc(lumplen);
+        W_ReadLump(lumpnum, rejectmatrix);
     }
     else
     {
-        rejectmatrix = Z_Malloc(minlength, PU_LEVEL, &rejectmatrix);
+        rejectmatrix = P_LevelAlloc(minlength);
         W_ReadLump(lumpnum, rejectmatrix);
 
         PadRejectArray(rejectmatrix + lumplen, minlength - lumplen);
     }
 }
 
+//
+// LEVEL CACHE
+// With -levelcache, the level arena is written to a file once the
+//  map lumps have been loaded, and read back in one piece the next
+//  time the level is set up, in place of loading the lumps again.
+// Pointers in the file are offsets into the arena, so only the
+//  pointer fields are fixed up when it is read.  The file is for
+//  this build and WAD set alone: the key holds the sizes of the
+//  structures and a SHA1 of what the tables are built from.  That
+//  is PNAMES, TEXTURE1 and 2, the names of the flats (a flat's
+//  number is its place between F_START and F_END) and the WAD
+//  directory, summed once at startup, and where each map lump
+//  lies in its file and the file's length.  Making the key reads
+//  no lump, so a hit reads nothing but its file.  A file that does
+//  not match, or whose tables do not fit in its arena, is passed
+//  over.
+//
+#define LEVELCACHEVERSION	3
+
+// Stands in for the sector at the null address in the file.
+#define LEVELCACHENULLSECTOR	((uintptr_t) -1)
+
+typedef struct
+{
+    char		magic[8];
+    int			version;
+    int			structsizes[8];
+    sha1_digest_t	levelsum;
+    char		mapname[9];
+    boolean		rejectpadff;
+
+} levelcachekey_t;
+
+typedef struct
+{
+    levelcachekey_t	key;
+
+    int			arenasize;
+
+    int			numvertexes;
+    int			numsectors;
+    int			numsides;
+    int			numlines;
+    int			numsubsectors;
+    int			numnodes;
+    int			numsegs;
+    int			totallines;
+
+    int			bmapwidth;
+    int			bmapheight;
+    fixed_t		bmaporgx;
+    fixed_t		bmaporgy;
+
+    // offsets of the tables in the arena
+    int			vertexes;
+    int			sectors;
+    int			sides;
+    int			lines;
+    int			subsectors;
+    int			nodes;
+    int			nodeboxes;
+    int			bspstack;
+    int			segs;
+    int			blockmaplump;
+    int			blocklinks;
+    int			linebuffer;
+    int			rejectmatrix;
+
+} levelcache_t;
+
+static char*		levelcachedir;
+static sha1_digest_t	levelcachewadsum;
+static boolean		levelcachestray;
+
+
+//
+// P_LevelCacheAddLump
+//
+static void P_LevelCacheAddLump (sha1_context_t* context, int lump)
+{
+    byte*	data;
+
+    if (lump < 0)
+    {
+	SHA1_UpdateInt32 (context, 0);
+	return;
+    }
+
+    data = W_CacheLumpNum (lump, PU_STATIC);
+    SHA1_UpdateInt32 (context, W_LumpLength (lump));
+    SHA1_Update (context, data, W_LumpLength (lump));
+    W_ReleaseLumpNum (lump);
+}
+
+
+//
+// P_LevelCacheKey
+//
+static void
+P_LevelCacheKey
+( levelcachekey_t*	key,
+  char*			mapname,
+  int			lumpnum )
+{
+    sha1_context_t	context;
+    lumpinfo_t*		lump;
+    int			i;
+
+    // padding must compare equal too
+    memset (key, 0, sizeof(*key));
+
+    memcpy (key->magic, "LEVELCCH", sizeof(key->magic));
+    key->version = LEVELCACHEVERSION;
+
+    key->structsizes[0] = sizeof(void *);
+    key->structsizes[1] = sizeof(vertex_t);
+    key->structsizes[2] = sizeof(sector_t);
+    key->structsizes[3] = sizeof(side_t);
+    key->structsizes[4] = sizeof(line_t);
+    key->structsizes[5] = sizeof(subsector_t);
+    key->structsizes[6] = sizeof(node_t);
+    key->structsizes[7] = sizeof(seg_t);
+
+    SHA1_Init (&context);
+    SHA1_Update (&context, levelcachewadsum, sizeof(levelcachewadsum));
+
+    // the things are loaded every time, not from the cache
+    for (i=ML_LINEDEFS ; i<=ML_BLOCKMAP ; i++)
+    {
+	lump = &lumpinfo[lumpnum + i];
+	SHA1_UpdateInt32 (&context, lump->position);
+	SHA1_UpdateInt32 (&context, lump->size);
+	SHA1_UpdateInt32 (&context, lump->wad_file->length);
+    }
+
+    SHA1_Final (key->levelsum, &context);
+
+    M_StringCopy (key->mapname, mapname, sizeof(key->mapname));
+    key->rejectpadff = M_CheckParm ("-reject_pad_with_ff") > 0;
+}
+
+
+//
+// P_LevelCacheFile
+// Returns the file name for the key, to be freed by the caller.
+//
+static char* P_LevelCacheFile (levelcachekey_t* key)
+{
+    char	sum[17];
+    int		i;
+
+    for (i=0 ; i<8 ; i++)
+	M_snprintf (sum + i * 2, 3, "%02x", key->levelsum[i]);
+
+    return M_StringJoin (levelcachedir, key->mapname, "-", sum, ".lvl",
+			 NULL);
+}
+
+
+//
+// P_PackPointer
+// Turns a pointer into the arena into one past its offset.
+//
+static void* P_PackPointer (void* ptr)
+{
+    if (ptr == NULL)
+	return NULL;
+
+    if (ptr == GetSectorAtNullAddress ())
+	return (void *) LEVELCACHENULLSECTOR;
+
+    // A broken map can point past its tables.  Such a level is
+    // not written to the cache.
+    if ((byte *) ptr < levelarena || (byte *) ptr >= levelarena + levelarenaused)
+    {
+	levelcachestray = true;
+	return NULL;
+    }
+
+    return (void *) ((byte *) ptr - levelarena + 1);
+}
+
+
+//
+// P_UnpackPointer
+//
+static void* P_UnpackPointer (void* ptr)
+{
+    if (ptr == NULL)
+	return NULL;
+
+    if ((uintptr_t) ptr == LEVELCACHENULLSECTOR)
+	return GetSectorAtNullAddress ();
+
+    // Nor is a file read with a pointer past its arena.
+    if ((uintptr_t) ptr > (uintptr_t) levelarenaused)
+    {
+	levelcachestray = true;
+	return NULL;
+    }
+
+    return levelarena + ((uintptr_t) ptr - 1);
+}
+
+
+//
+// P_LevelCacheTable
+// True if count entries of size bytes at offset fit in the arena.
+//
+static boolean
+P_LevelCacheTable
+( levelcache_t*		header,
+  int			offset,
+  int			count,
+  size_t		size )
+{
+    return offset >= 0 && offset <= header->arenasize
+	&& LEVELALIGN(offset) == offset
+	&& count >= 0
+	&& (size_t) count <= (header->arenasize - offset) / size;
+}
+
+
+//
+// P_LevelCacheTablesFit
+// Checks every table in the header against its arena, so that a
+// damaged file is not read past its end.
+//
+static boolean P_LevelCacheTablesFit (levelcache_t* header)
+{
+    int64_t	blocks;
+    int64_t	rejectsize;
+
+    blocks = (int64_t) header->bmapwidth * header->bmapheight;
+    rejectsize = ((int64_t) header->numsectors * header->numsectors + 7) / 8;
+
+    if (header->bmapwidth < 0 || header->bmapheight < 0
+     || blocks > header->arenasize || rejectsize > header->arenasize)
+	return false;
+
+    return P_LevelCacheTable (header, header->vertexes,
+			      header->numvertexes, sizeof(vertex_t))
+	&& P_LevelCacheTable (header, header->sectors,
+			      header->numsectors, sizeof(sector_t))
+	&& P_LevelCacheTable (header, header->sides,
+			      header->numsides, sizeof(side_t))
+	&& P_LevelCacheTable (header, header->lines,
+			      header->numlines, sizeof(line_t))
+	&& P_LevelCacheTable (header, header->subsectors,
+			      header->numsubsectors, sizeof(subsector_t))
+	&& P_LevelCacheTable (header, header->nodes,
+			      header->numnodes, sizeof(node_t))
+	&& P_LevelCacheTable (header, header->nodeboxes,
+			      header->numnodes, sizeof(nodebox_t))
+	&& P_LevelCacheTable (header, header->bspstack,
+			      header->numnodes, sizeof(*bspstack))
+	&& P_LevelCacheTable (header, header->segs,
+			      header->numsegs, sizeof(seg_t))
+	&& P_LevelCacheTable (header, header->blockmaplump,
+			      4 + blocks, sizeof(*blockmaplump))
+	&& P_LevelCacheTable (header, header->blocklinks,
+			      blocks, sizeof(*blocklinks))
+	&& P_LevelCacheTable (header, header->linebuffer,
+			      header->totallines, sizeof(*linebuffer))
+	&& P_LevelCacheTable (header, header->rejectmatrix,
+			      rejectsize, 1);
+}
+
+
+//
+// P_RelocateLevel
+// Passes every pointer in the arena image at base through reloc.
+//
+static void
+P_RelocateLevel
+( byte*			base,
+  levelcache_t*		header,
+  void*			(*reloc) (void* ptr) )
+{
+    sector_t*		sector;
+    side_t*		side;
+    line_t*		line;
+    subsector_t*	ss;
+    seg_t*		seg;
+    line_t**		list;
+    int			i;
+
+    sector = (sector_t *) (base + header->sectors);
+    for (i=0 ; i<header->numsectors ; i++, sector++)
+	sector->lines = reloc (sector->lines);
+
+    side = (side_t *) (base + header->sides);
+    for (i=0 ; i<header->numsides ; i++, side++)
+	side->sector = reloc (side->sector);
+
+    line = (line_t *) (base + header->lines);
+    for (i=0 ; i<header->numlines ; i++, line++)
+    {
+	line->v1 = reloc (line->v1);
+	line->v2 = reloc (line->v2);
+	line->frontsector = reloc (line->frontsector);
+	line->backsector = reloc (line->backsector);
+    }
+
+    ss = (subsector_t *) (base + header->subsectors);
+    for (i=0 ; i<header->numsubsectors ; i++, ss++)
+	ss->sector = reloc (ss->sector);
+
+    seg = (seg_t *) (base + header->segs);
+    for (i=0 ; i<header->numsegs ; i++, seg++)
+    {
+	seg->v1 = reloc (seg->v1);
+	seg->v2 = reloc (seg->v2);
+	seg->sidedef = reloc (seg->sidedef);
+	seg->linedef = reloc (seg->linedef);
+	seg->frontsector = reloc (seg->frontsector);
+	seg->backsector = reloc (seg->backsector);
+    }
+
+    list = (line_t **) (base + header->linebuffer);
+    for (i=0 ; i<header->totallines ; i++, list++)
+	*list = reloc (*list);
+}
+
+
+//
+// P_WriteLevelCache
+//
+static void P_WriteLevelCache (levelcachekey_t* key)
+{
+    levelcache_t	header;
+    byte*		image;
+    char*		filename;
+    FILE*		f;
+    boolean		ok;
+
+    // a table outside the arena would not be in the file
+    if (levelcachedir == NULL || levelarenaoverflow)
+	return;
+
+    header.key = *key;
+
+    header.arenasize = levelarenaused;
+
+    header.numvertexes = numvertexes;
+    header.numsectors = numsectors;
+    header.numsides = numsides;
+    header.numlines = numlines;
+    header.numsubsectors = numsubsectors;
+    header.numnodes = numnodes;
+    header.numsegs = numsegs;
+    header.totallines = totallines;
+
+    header.bmapwidth = bmapwidth;
+    header.bmapheight = bmapheight;
+    header.bmaporgx = bmaporgx;
+    header.bmaporgy = bmaporgy;
+
+    header.vertexes = (byte *) vertexes - levelarena;
+    header.sectors = (byte *) sectors - levelarena;
+    header.sides = (byte *) sides - levelarena;
+    header.lines = (byte *) lines - levelarena;
+    header.subsectors = (byte *) subsectors - levelarena;
+    header.nodes = (byte *) nodes - levelarena;
+    header.nodeboxes = (byte *) nodeboxes - levelarena;
+    header.bspstack = (byte *) bspstack - levelarena;
+    header.segs = (byte *) segs - levelarena;
+    header.blockmaplump = (byte *) blockmaplump - levelarena;
+    header.blocklinks = (byte *) blocklinks - levelarena;
+    header.linebuffer = (byte *) linebuffer - levelarena;
+    header.rejectmatrix = rejectmatrix - levelarena;
+
+    image = malloc (levelarenaused);
+
+    if (image == NULL)
+	return;
+
+    memcpy (image, levelarena, levelarenaused);
+
+    levelcachestray = false;
+    P_RelocateLevel (image, &header, P_PackPointer);
+
+    if (levelcachestray)
+    {
+	free (image);
+	return;
+    }
+
+    filename = P_LevelCacheFile (&header.key);
+    f = fopen (filename, "wb");
+
+    if (f != NULL)
+    {
+	ok = fwrite (&header, sizeof(header), 1, f) == 1
+	  && fwrite (image, 1, levelarenaused, f) == levelarenaused;
+	ok = fclose (f) == 0 && ok;
+
+	// a part written file must not be read next time
+	if (!ok)
+	    remove (filename);
+    }
+
+    free (filename);
+    free (image);
+}
+
+
+//
+// P_ReadLevelCache
+// Sets up the level's tables from its file in the level cache.
+// Returns false if there is no file for the level as it is now,
+// or if the file is not whole.
+//
+static boolean P_ReadLevelCache (levelcachekey_t* key)
+{
+    levelcache_t	header;
+    char*		filename;
+    FILE*		f;
+    long		filesize;
+    boolean		ok;
+
+    if (levelcachedir == NULL)
+	return false;
+
+    filename = P_LevelCacheFile (key);
+    f = fopen (filename, "rb");
+    free (filename);
+
+    if (f == NULL)
+	return false;
+
+    filesize = -1;
+
+    if (fseek (f, 0, SEEK_END) == 0)
+    {
+	filesize = ftell (f);
+	rewind (f);
+    }
+
+    if (fread (&header, sizeof(header), 1, f) != 1
+     || memcmp (&header.key, key, sizeof(*key)) != 0
+     || header.arenasize <= 0
+     || filesize != (long) sizeof(header) + header.arenasize
+     || !P_LevelCacheTablesFit (&header))
+    {
+	fclose (f);
+	return false;
+    }
+
+    levelarenasize = header.arenasize;
+    levelarena = Z_Malloc (levelarenasize, PU_STATIC, &levelarena);
+    levelarenaused = levelarenasize;
+
+    ok = fread (levelarena, 1, levelarenasize, f) == levelarenasize;
+    fclose (f);
+
+    if (ok)
+    {
+	levelcachestray = false;
+	P_RelocateLevel (levelarena, &header, P_UnpackPointer);
+	ok = !levelcachestray;
+    }
+
+    if (!ok)
+    {
+	Z_Free (levelarena);
+	return false;
+    }
+
+    numvertexes = header.numvertexes;
+    numsectors = header.numsectors;
+    numsides = header.numsides;
+    numlines = header.numlines;
+    numsubsectors = header.numsubsectors;
+    numnodes = header.numnodes;
+    numsegs = header.numsegs;
+    totallines = header.totallines;
+
+    bmapwidth = header.bmapwidth;
+    bmapheight = header.bmapheight;
+    bmaporgx = header.bmaporgx;
+    bmaporgy = header.bmaporgy;
+
+    vertexes = (vertex_t *) (levelarena + header.vertexes);
+    sectors = (sector_t *) (levelarena + header.sectors);
+    sides = (side_t *) (levelarena + header.sides);
+    lines = (line_t *) (levelarena + header.lines);
+    subsectors = (subsector_t *) (levelarena + header.subsectors);
+    nodes = (node_t *) (levelarena + header.nodes);
+    nodeboxes = (nodebox_t *) (levelarena + header.nodeboxes);
+    bspstack = (int *) (levelarena + header.bspstack);
+    segs = (seg_t *) (levelarena + header.segs);
+    blockmaplump = (short *) (levelarena + header.blockmaplump);
+    blockmap = blockmaplump + 4;
+    blocklinks = (mobj_t **) (levelarena + header.blocklinks);
+    linebuffer = (line_t **) (levelarena + header.linebuffer);
+    rejectmatrix = levelarena + header.rejectmatrix;
+
+    return true;
+}
+
+
+//
+// P_LevelCacheWadSum
+// Sums what every level's tables depend on, besides the map.
+//
+static void P_LevelCacheWadSum (void)
+{
+    sha1_context_t	context;
+    sha1_digest_t	directory;
+    int			lastflat;
+    int			i;
+
+    W_Checksum (directory);
+
+    SHA1_Init (&context);
+    SHA1_Update (&context, directory, sizeof(directory));
+
+    P_LevelCacheAddLump (&context, W_CheckNumForName (DEH_String("PNAMES")));
+    P_LevelCacheAddLump (&context, W_CheckNumForName (DEH_String("TEXTURE1")));
+    P_LevelCacheAddLump (&context, W_CheckNumForName (DEH_String("TEXTURE2")));
+
+    lastflat = W_GetNumForName (DEH_String("F_END"));
+
+    for (i=firstflat ; i<lastflat ; i++)
+	SHA1_Update (&context, (byte *) lumpinfo[i].name, 8);
+
+    SHA1_Final (levelcachewadsum, &context);
+}
+
+
+//
+// P_InitLevelCache
+//
+static void P_InitLevelCache (void)
+{
+    //!
+    // @category obscure
+    //
+    // Keep each level's tables, once loaded, in files in the
+    // levelcache directory, and set up the level from its file
+    // the next time it is played with the same WADs.
+    //
+
+    if (!M_CheckParm ("-levelcache"))
+	return;
+
+    levelcachedir = M_StringJoin (configdir, "levelcache", DIR_SEPARATOR_S,
+				  NULL);
+    M_MakeDirectory (levelcachedir);
+
+    P_LevelCacheWadSum ();
+}
+
+//
+// P_MapLumpName
+// The name of a map's first lump, in a buffer of 9.
+//
+static void P_MapLumpName (char* lumpname, int episode, int map)
+{
+    if ( gamemode == commercial)
+    {
+	if (map<10)
+	    DEH_snprintf(lumpname, 9, "map0%i", map);
+	else
+	    DEH_snprintf(lumpname, 9, "map%i", map);
+    }
+    else
+    {
+	lumpname[0] = 'E';
+	lumpname[1] = '0' + episode;
+	lumpname[2] = 'M';
+	lumpname[3] = '0' + map;
+	lumpname[4] = 0;
+    }
+}
+
+//
+// P_PrefetchLevelLumps
+// Reads ahead a map's lumps and the graphics it names.
+// Runs on the prefetch thread, so uses nothing but the
+// lump directory and tables set up at startup.
+//
+static void P_PrefetchLevelLumps (int lumpnum)
+{
+    mapsidedef_t*	msd;
+    mapsector_t*	ms;
+    mapthing_t*		mt;
+    byte*		data;
+    char		name[9];
+    int			num;
+    int			i;
+    int			j;
+
+    for (i=ML_THINGS ; i<=ML_BLOCKMAP ; i++)
+	W_WarmLump (lumpnum+i);
+
+    // wall textures
+    data = W_ReadLumpShared (lumpnum+ML_SIDEDEFS);
+    if (data)
+    {
+	num = W_LumpLength (lumpnum+ML_SIDEDEFS) / sizeof(mapsidedef_t);
+	msd = (mapsidedef_t *)data;
+	for (i=0 ; i<num ; i++, msd++)
+	{
+	    R_PrefetchTexture (msd->toptexture);
+	    R_PrefetchTexture (msd->bottomtexture);
+	    R_PrefetchTexture (msd->midtexture);
+	}
+	free (data);
+    }
+
+    // flats
+    data = W_ReadLumpShared (lumpnum+ML_SECTORS);
+    if (data)
+    {
+	num = W_LumpLength (lumpnum+ML_SECTORS) / sizeof(mapsector_t);
+	ms = (mapsector_t *)data;
+	name[8] = 0;
+	for (i=0 ; i<num ; i++, ms++)
+	{
+	    memcpy (name, ms->floorpic, 8);
+	    W_WarmLump (W_CheckNumForName (name));
+	    memcpy (name, ms->ceilingpic, 8);
+	    W_WarmLump (W_CheckNumForName (name));
+	}
+	free (data);
+    }
+
+    // sprites of the things spawned
+    data = W_ReadLumpShared (lumpnum+ML_THINGS);
+    if (data)
+    {
+	num = W_LumpLength (lumpnum+ML_THINGS) / sizeof(mapthing_t);
+	mt = (mapthing_t *)data;
+	for (i=0 ; i<num ; i++, mt++)
+	{
+	    for (j=0 ; j<NUMMOBJTYPES ; j++)
+	    {
+		if (mobjinfo[j].doomednum == SHORT(mt->type))
+		{
+		    R_PrefetchSprite (states[mobjinfo[j].spawnstate].sprite);
+		    break;
+		}
+	    }
+	}
+	free (data);
+    }
+}
+
+//
+// P_PrefetchLevel
+// Starts reading ahead a map that is to be set up soon.
+//
+void P_PrefetchLevel (int episode, int map)
+{
+    char	lumpname[9];
+    int		lumpnum;
+
+    P_MapLumpName (lumpname, episode, map);
+    lumpnum = W_CheckNumForName (lumpname);
+
+    if (lumpnum != -1 && lumpnum + ML_BLOCKMAP < numlumps)
+	W_StartPrefetch (P_PrefetchLevelLumps, lumpnum);
+}
+
 //
 // P_SetupLevel
 //
@@ -750,6 +1593,9 @@ P_SetupLevel
     int		i;
     char	lumpname[9];
     int		lumpnum;
+    int		loadtime;
+    boolean	fromcache;
+    levelcachekey_t	cachekey;
 	
     totalkills = totalitems = totalsecret = wminfo.maxfrags = 0;
     wminfo.partime = 180;
@@ -764,47 +1610,72 @@ P_SetupLevel
     players[consoleplayer].viewz = 1; 
 
     // Make sure all sounds are stopped before Z_FreeTags.
-    S_Start ();			
+    S_Start ();
+
+    // lump cache use since the last level was set up
+    if (devparm && lumpcachehits + lumpcachemisses > 0)
+    {
+	printf ("P_SetupLevel: lump cache %i hits, %i reads, "
+		"%i read again after a purge\n",
+		lumpcachehits, lumpcachemisses, lumpcacherereads);
+    }
 
+    lumpcachehits = 0;
+    lumpcachemisses = 0;
+    lumpcacherereads = 0;
+
+    R_FreeTextureArena ();
+    P_FreeLevelArena ();
     Z_FreeTags (PU_LEVEL, PU_PURGELEVEL-1);
+    P_ClearThinkerPools ();
 
     // UNUSED W_Profile ();
     P_InitThinkers ();
 	   
-    // find map name
-    if ( gamemode == commercial)
-    {
-	if (map<10)
-	    DEH_snprintf(lumpname, 9, "map0%i", map);
-	else
-	    DEH_snprintf(lumpname, 9, "map%i", map);
-    }
-    else
-    {
-	lumpname[0] = 'E';
-	lumpname[1] = '0' + episode;
-	lumpname[2] = 'M';
-	lumpname[3] = '0' + map;
-	lumpname[4] = 0;
-    }
-
+    P_MapLumpName (lumpname, episode, map);
     lumpnum = W_GetNumForName (lumpname);
 	
     leveltime = 0;
-	
-    // note: most of this ordering is important	
-    P_LoadBlockMap (lumpnum+ML_BLOCKMAP);
-    P_LoadVertexes (lumpnum+ML_VERTEXES);
-    P_LoadSectors (lumpnum+ML_SECTORS);
-    P_LoadSideDefs (lumpnum+ML_SIDEDEFS);
 
-    P_LoadLineDefs (lumpnum+ML_LINEDEFS);
-    P_LoadSubsectors (lumpnum+ML_SSECTORS);
-    P_LoadNodes (lumpnum+ML_NODES);
-    P_LoadSegs (lumpnum+ML_SEGS);
+    loadtime = I_GetTimeMS ();
 
-    P_GroupLines ();
-    P_LoadReject (lumpnum+ML_REJECT);
+    // one key for the read and, on a miss, the write
+    if (levelcachedir != NULL)
+	P_LevelCacheKey (&cachekey, lumpname, lumpnum);
+
+    fromcache = P_ReadLevelCache (&cachekey);
+
+    if (!fromcache)
+    {
+	// the level's tables go in one block, in the order loaded
+	levelarenasize = P_LevelArenaSize (lumpnum);
+	levelarena = Z_Malloc (levelarenasize, PU_STATIC, &levelarena);
+	levelarenaused = 0;
+	levelarenaoverflow = false;
+
+	// note: most of this ordering is important	
+	P_LoadBlockMap (lumpnum+ML_BLOCKMAP);
+	P_LoadVertexes (lumpnum+ML_VERTEXES);
+	P_LoadSectors (lumpnum+ML_SECTORS);
+	P_LoadSideDefs (lumpnum+ML_SIDEDEFS);
+
+	P_LoadLineDefs (lumpnum+ML_LINEDEFS);
+	P_LoadSubsectors (lumpnum+ML_SSECTORS);
+	P_LoadNodes (lumpnum+ML_NODES);
+	P_LoadSegs (lumpnum+ML_SEGS);
+
+	P_GroupLines ();
+	P_LoadReject (lumpnum+ML_REJECT);
+
+	P_WriteLevelCache (&cachekey);
+    }
+
+    if (devparm)
+    {
+	printf ("P_SetupLevel: %s tables set up in %i ms%s\n", lumpname,
+		I_GetTimeMS () - loadtime,
+		fromcache ? " from the level cache" : "");
+    }
 
     bodyqueslot = 0;
     deathmatch_p = deathmatchstarts;
@@ -831,9 +1702,14 @@ P_SetupLevel
     // build subsector connect matrix
     //	UNUSED P_ConnectSubsectors ();
 
+    // fresh render high water marks for this level
+    R_ClearLevelPeaks ();
+
     // preload graphics
     if (precache)
 	R_PrecacheLevel ();
+    else
+	R_LevelLookups ();
 
     //printf ("free memory: 0x%x\n", Z_FreeMemory());
 
@@ -849,6 +1725,8 @@ void P_Init (void)
     P_InitSwitchList ();
     P_InitPicAnims ();
     R_InitSprites (sprnames);
+    P_InitLevelCache ();
+    W_InitPrefetch ();
 }
 
 
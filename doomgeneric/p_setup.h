@@ -31,6 +31,9 @@ P_SetupLevel
   int		playermask,
   skill_t	skill);
 
+// Reads ahead a map to be set up soon, if prefetching.
+void P_PrefetchLevel (int episode, int map);
+
 // Called by startup code.
 void P_Init (void);
 
@@ -250,44 +250,78 @@ boolean P_CrossSubsector (int num)
 
 
 
+//
+// P_NodeDivline
+// The partition line of a node, in fixed point.
+//
+static void P_NodeDivline (node_t* node, divline_t* dl)
+{
+    dl->x = node->x<<FRACBITS;
+    dl->y = node->y<<FRACBITS;
+    dl->dx = node->dx<<FRACBITS;
+    dl->dy = node->dy<<FRACBITS;
+}
+
+
 //
 // P_CrossBSPNode
 // Returns true
 //  if strace crosses the given node successfully.
+// Walks the tree with bspstack instead of recursing.
 //
 boolean P_CrossBSPNode (int bspnum)
 {
     node_t*	bsp;
+    divline_t	partition;
+    int*	sp;
     int		side;
 
-    if (bspnum & NF_SUBSECTOR)
+    sp = bspstack;
+
+    for (;;)
     {
+	// Cross the starting sides down to a subsector.
+	while (!(bspnum & NF_SUBSECTOR))
+	{
+	    bsp = &nodes[bspnum];
+	    P_NodeDivline (bsp, &partition);
+
+	    // decide which side the start point is on
+	    side = P_DivlineSide (strace.x, strace.y, &partition);
+	    if (side == 2)
+		side = 0;	// an "on" should cross both sides
+
+	    *sp++ = (bspnum << 1) | side;
+	    bspnum = bsp->children[side];
+	}
+
 	if (bspnum == -1)
-	    return P_CrossSubsector (0);
-	else
-	    return P_CrossSubsector (bspnum&(~NF_SUBSECTOR));
-    }
-		
-    bsp = &nodes[bspnum];
-    
-    // decide which side the start point is on
-    side = P_DivlineSide (strace.x, strace.y, (divline_t *)bsp);
-    if (side == 2)
-	side = 0;	// an "on" should cross both sides
-
-    // cross the starting side
-    if (!P_CrossBSPNode (bsp->children[side]) )
-	return false;
-	
-    // the partition plane is crossed here
-    if (side == P_DivlineSide (t2x, t2y,(divline_t *)bsp))
-    {
-	// the line doesn't touch the other side
-	return true;
+	{
+	    if (!P_CrossSubsector (0))
+		return false;
+	}
+	else if (!P_CrossSubsector (bspnum&(~NF_SUBSECTOR)))
+	    return false;
+
+	// Back up to the nearest node whose ending side
+	// the line still has to cross.
+	do
+	{
+	    if (sp == bspstack)
+		return true;
+
+	    sp--;
+	    bspnum = *sp >> 1;
+	    side = *sp & 1;
+	    P_NodeDivline (&nodes[bspnum], &partition);
+
+	    // the partition plane is crossed here; if the line
+	    // doesn't touch the other side this node is done
+	} while (side == P_DivlineSide (t2x, t2y, &partition));
+
+	// cross the ending side
+	bspnum = nodes[bspnum].children[side^1];
     }
-    
-    // cross the ending side		
-    return P_CrossBSPNode (bsp->children[side^1]);
 }
 
 
@@ -124,6 +124,16 @@ EV_Teleport
 
 		thing->angle = m->angle;
 		thing->momx = thing->momy = thing->momz = 0;
+
+		// Do not draw it moving across the map.
+		thing->oldx = thing->x;
+		thing->oldy = thing->y;
+		thing->oldz = thing->z;
+		thing->oldangle = thing->angle;
+
+		if (thing->player)
+		    thing->player->oldviewz = thing->player->viewz;
+
 		return 1;
 	    }	
 	}
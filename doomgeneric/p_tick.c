@@ -18,8 +18,10 @@
 //
 
 
+#include "i_system.h"
 #include "z_zone.h"
 #include "p_local.h"
+#include "d_main.h"
 
 #include "doomstat.h"
 
@@ -28,7 +30,7 @@ int	leveltime;
 
 //
 // THINKERS
-// All thinkers should be allocated by Z_Malloc
+// All thinkers should be allocated by P_AllocThinker
 // so they can be operated on uniformly.
 // The actual structures will vary in size,
 // but the first element must be thinker_t.
@@ -79,11 +81,121 @@ void P_RemoveThinker (thinker_t* thinker)
 
 
 //
-// P_AllocateThinker
-// Allocates memory and adds a new thinker at the end of the list.
+// THINKER POOLS
+// Thinkers are kept in a pool for each size, cut from chunks
+// of level memory that start on a cache line.  A removed thinker
+// goes on its pool's free list and is the next one handed out,
+// so a fight spawning and removing things does not go through
+// the zone.  The chunks go with the rest of the level in
+// Z_FreeTags, after which P_ClearThinkerPools must be called.
 //
-void P_AllocateThinker (thinker_t*	thinker)
+#define MAXTHINKERPOOLS		16
+#define THINKERSPERCHUNK	64
+#define CACHELINE		64
+
+typedef struct thinkerslot_s thinkerslot_t;
+
+typedef struct
+{
+    int			size;		// thinker size given
+    int			stride;		// slot size, with the header
+    thinkerslot_t*	freeslots;
+    byte*		chunk;		// next unused slot
+    int			chunkleft;
+
+} thinkerpool_t;
+
+// In front of every pooled thinker.  The thinker itself is not
+// written when it is freed, as P_RunThinkers follows its next
+// link after freeing it.
+struct thinkerslot_s
+{
+    thinkerpool_t*	pool;
+    thinkerslot_t*	nextfree;
+};
+
+static thinkerpool_t	thinkerpools[MAXTHINKERPOOLS];
+static int		numthinkerpools;
+
+
+//
+// P_ClearThinkerPools
+//
+void P_ClearThinkerPools (void)
+{
+    numthinkerpools = 0;
+}
+
+
+//
+// P_AllocThinker
+// Returns memory for a thinker of the given size.
+// It is not cleared, as Z_Malloc does not clear.
+//
+void* P_AllocThinker (int size)
+{
+    thinkerpool_t*	pool;
+    thinkerslot_t*	slot;
+    byte*		chunk;
+
+    for (pool = thinkerpools ; pool < thinkerpools + numthinkerpools ; pool++)
+    {
+	if (pool->size == size)
+	    break;
+    }
+
+    if (pool == thinkerpools + numthinkerpools)
+    {
+	if (numthinkerpools == MAXTHINKERPOOLS)
+	    I_Error ("P_AllocThinker: more than %i thinker sizes",
+		     MAXTHINKERPOOLS);
+
+	pool->size = size;
+	pool->stride = (sizeof(thinkerslot_t) + size + sizeof(void *) - 1)
+		     & ~(sizeof(void *) - 1);
+	pool->freeslots = NULL;
+	pool->chunkleft = 0;
+	numthinkerpools++;
+    }
+
+    if (pool->freeslots != NULL)
+    {
+	slot = pool->freeslots;
+	pool->freeslots = slot->nextfree;
+    }
+    else
+    {
+	if (pool->chunkleft == 0)
+	{
+	    chunk = Z_Malloc (pool->stride * THINKERSPERCHUNK + CACHELINE - 1,
+			      PU_LEVEL, NULL);
+	    pool->chunk = (byte *) (((uintptr_t) chunk + CACHELINE - 1)
+				    & ~(uintptr_t) (CACHELINE - 1));
+	    pool->chunkleft = THINKERSPERCHUNK;
+	}
+
+	slot = (thinkerslot_t *) pool->chunk;
+	pool->chunk += pool->stride;
+	pool->chunkleft--;
+    }
+
+    slot->pool = pool;
+
+    return slot + 1;
+}
+
+
+//
+// P_FreeThinker
+// Gives a thinker from P_AllocThinker back to its pool.
+//
+void P_FreeThinker (thinker_t* thinker)
 {
+    thinkerslot_t*	slot;
+
+    slot = (thinkerslot_t *) thinker - 1;
+    slot->nextfree = slot->pool->freeslots;
+    slot->pool->freeslots = slot;
 }
 
 
@@ -103,7 +215,7 @@ void P_RunThinkers (void)
 	    // time to remove it
 	    currentthinker->next->prev = currentthinker->prev;
 	    currentthinker->prev->next = currentthinker->next;
-	    Z_Free (currentthinker);
+	    P_FreeThinker (currentthinker);
 	}
 	else
 	{
@@ -116,6 +228,62 @@ void P_RunThinkers (void)
 
 
 
+//
+// P_KeepOldPositions
+// Keeps where the mobjs, player views and sector planes are
+// before the tic is run, so that frames drawn in between tics
+// can move them from there.
+//
+int		oldpositionstic = -1;
+
+static mobj_t*	oldviewmobjs[MAXPLAYERS];
+
+static void P_KeepOldPositions (void)
+{
+    thinker_t*	th;
+    mobj_t*	mo;
+    player_t*	player;
+    sector_t*	sector;
+    int		i;
+
+    for (th = thinkercap.next ; th != &thinkercap ; th = th->next)
+    {
+	if (th->function.acp1 != (actionf_p1) P_MobjThinker)
+	    continue;
+
+	mo = (mobj_t *) th;
+	mo->oldx = mo->x;
+	mo->oldy = mo->y;
+	mo->oldz = mo->z;
+	mo->oldangle = mo->angle;
+    }
+
+    for (i=0 ; i<MAXPLAYERS ; i++)
+    {
+	if (!playeringame[i])
+	    continue;
+
+	player = &players[i];
+
+	// A player spawned since the last tic has no view yet.
+	if (leveltime == 0 || player->mo != oldviewmobjs[i])
+	    player->oldviewz = player->mo->z + player->viewheight;
+	else
+	    player->oldviewz = player->viewz;
+
+	oldviewmobjs[i] = player->mo;
+    }
+
+    for (i=0, sector=sectors ; i<numsectors ; i++, sector++)
+    {
+	sector->oldfloorheight = sector->floorheight;
+	sector->oldceilingheight = sector->ceilingheight;
+    }
+
+    oldpositionstic = gametic;
+}
+
+
 //
 // P_Ticker
 //
@@ -136,7 +304,10 @@ void P_Ticker (void)
     {
 	return;
     }
-    
+
+    // Only R_InterpolateLevel reads them, when drawing between tics.
+    if (uncapped_framerate > 0)
+	P_KeepOldPositions ();
 		
     for (i=0 ; i<MAXPLAYERS ; i++)
 	if (playeringame[i])
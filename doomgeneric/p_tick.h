@@ -28,6 +28,10 @@
 // Carries out all thinking of monsters and players.
 void P_Ticker (void);
 
+// gametic of the last tic whose old positions were kept,
+// or -1 if none were.
+extern int	oldpositionstic;
+
 
 
 #endif
@@ -24,6 +24,8 @@
 #include "m_bbox.h"
 
 #include "i_system.h"
+#include "i_video.h"
+#include "z_zone.h"
 
 #include "r_main.h"
 #include "r_plane.h"
@@ -43,9 +45,15 @@ line_t*		linedef;
 sector_t*	frontsector;
 sector_t*	backsector;
 
-drawseg_t	drawsegs[MAXDRAWSEGS];
+// drawsegs start out at the vanilla size and grow on demand,
+// unless vanilla_render_limit is set.
+drawseg_t*	drawsegs;
+int		maxdrawsegs;
 drawseg_t*	ds_p;
 
+// High water mark for the current level.
+int		peakdrawsegs;
+
 
 void
 R_StoreWallRange
@@ -55,11 +63,40 @@ R_StoreWallRange
 
 
 
+//
+// R_GrowDrawSegs
+// Doubles the drawseg array, keeping the segs stored so far.
+// Only called when ds_p has reached the end of the array.
+//
+void R_GrowDrawSegs (void)
+{
+    drawseg_t*	newdrawsegs;
+    int		newmax;
+
+    newmax = maxdrawsegs ? maxdrawsegs * 2 : MAXDRAWSEGS;
+    newdrawsegs = Z_Malloc (newmax * sizeof(*newdrawsegs), PU_STATIC, NULL);
+
+    if (drawsegs != NULL)
+    {
+	memcpy (newdrawsegs, drawsegs, maxdrawsegs * sizeof(*drawsegs));
+	Z_Free (drawsegs);
+    }
+
+    ds_p = newdrawsegs + (ds_p - drawsegs);
+    drawsegs = newdrawsegs;
+    maxdrawsegs = newmax;
+}
+
+
+
 //
 // R_ClearDrawSegs
 //
 void R_ClearDrawSegs (void)
 {
+    if (drawsegs == NULL)
+	R_GrowDrawSegs ();
+
     ds_p = drawsegs;
 }
 
@@ -82,9 +119,120 @@ typedef	struct
 
 // newend is one past the last valid seg
 cliprange_t*	newend;
-cliprange_t	solidsegs[MAXSEGS];
+cliprange_t*	solidsegs;
+int		maxsolidsegs;
 
+// High water mark for the current level.
+int		peaksolidsegs;
 
+// One bit per view column, set once a solid wall covers it.
+// It always agrees with solidsegs, but a span of columns can
+// be tested against it a word at a time.
+#define SOLIDCOLUMNWORDS	((ORIGWIDTH << MAXHIRES) / 32)
+
+static unsigned int	solidcolumns[SOLIDCOLUMNWORDS];
+
+// Once solidsegs is down to a single post, every column is
+// covered and nothing more can be drawn.
+#define SCREENFULL	(newend == solidsegs + 1)
+
+
+
+//
+// R_GrowSolidSegs
+// Doubles the clip list. There can never be more than
+// viewwidth/2+2 posts, so this settles after the first
+// few frames.
+//
+static void R_GrowSolidSegs (void)
+{
+    cliprange_t*	newsolidsegs;
+    int			newmax;
+
+    if (vanilla_render_limit && maxsolidsegs >= MAXSEGS)
+	I_Error ("R_ClipSolidWallSegment: solidsegs overflow (%i)",
+		 maxsolidsegs);
+
+    newmax = maxsolidsegs ? maxsolidsegs * 2 : MAXSEGS;
+    newsolidsegs = Z_Malloc (newmax * sizeof(*newsolidsegs), PU_STATIC, NULL);
+
+    if (solidsegs != NULL)
+    {
+	memcpy (newsolidsegs, solidsegs, maxsolidsegs * sizeof(*solidsegs));
+	Z_Free (solidsegs);
+    }
+
+    newend = newsolidsegs + (newend - solidsegs);
+    solidsegs = newsolidsegs;
+    maxsolidsegs = newmax;
+}
+
+
+
+
+//
+// R_MarkSolidColumns
+//
+static void R_MarkSolidColumns (int first, int last)
+{
+    unsigned int	mask;
+    int			i;
+
+    if (first < 0)
+	first = 0;
+
+    if (last >= viewwidth)
+	last = viewwidth - 1;
+
+    if (first > last)
+	return;
+
+    mask = ~0u << (first & 31);
+
+    for (i = first >> 5 ; i < last >> 5 ; i++)
+    {
+	solidcolumns[i] |= mask;
+	mask = ~0u;
+    }
+
+    solidcolumns[i] |= mask & (~0u >> (31 - (last & 31)));
+}
+
+
+//
+// R_ColumnsSolid
+// Returns true if solid walls already cover every column
+//  from first to last. Columns off the view count as covered,
+//  as they are in solidsegs.
+//
+static boolean R_ColumnsSolid (int first, int last)
+{
+    unsigned int	mask;
+    int			i;
+
+    if (first < 0)
+	first = 0;
+
+    if (last >= viewwidth)
+	last = viewwidth - 1;
+
+    if (first > last)
+	return true;
+
+    mask = ~0u << (first & 31);
+
+    for (i = first >> 5 ; i < last >> 5 ; i++)
+    {
+	if ((solidcolumns[i] & mask) != mask)
+	    return false;
+
+	mask = ~0u;
+    }
+
+    mask &= ~0u >> (31 - (last & 31));
+
+    return (solidcolumns[i] & mask) == mask;
+}
 
 
 //
@@ -101,6 +249,9 @@ R_ClipSolidWallSegment
     cliprange_t*	next;
     cliprange_t*	start;
 
+    // The columns are solid however this returns.
+    R_MarkSolidColumns (first, last);
+
     // Find the first range that touches the range
     //  (adjacent pixels are touching).
     start = solidsegs;
@@ -114,8 +265,20 @@ R_ClipSolidWallSegment
 	    // Post is entirely visible (above start),
 	    //  so insert a new clippost.
 	    R_StoreWallRange (first, last);
+
+	    if (newend == solidsegs + maxsolidsegs)
+	    {
+		int	startindex = start - solidsegs;
+
+		R_GrowSolidSegs ();
+		start = solidsegs + startindex;
+	    }
+
 	    next = newend;
 	    newend++;
+
+	    if (newend - solidsegs > peaksolidsegs)
+		peaksolidsegs = newend - solidsegs;
 	    
 	    while (next != start)
 	    {
@@ -237,11 +400,16 @@ R_ClipPassWallSegment
 //
 void R_ClearClipSegs (void)
 {
+    if (solidsegs == NULL)
+	R_GrowSolidSegs ();
+
     solidsegs[0].first = -0x7fffffff;
     solidsegs[0].last = -1;
     solidsegs[1].first = viewwidth;
     solidsegs[1].last = 0x7fffffff;
     newend = solidsegs+2;
+
+    memset (solidcolumns, 0, ((viewwidth + 31) >> 5) * sizeof(*solidcolumns));
 }
 
 //
@@ -260,6 +428,9 @@ void R_AddLine (seg_t*	line)
     
     curline = line;
 
+    if (SCREENFULL)
+	return;
+
     // OPTIMIZE: quickly reject orthogonal back sides.
     angle1 = R_PointToAngle (line->v1->x, line->v1->y);
     angle2 = R_PointToAngle (line->v2->x, line->v2->y);
@@ -309,6 +480,11 @@ void R_AddLine (seg_t*	line)
     // Does not cross a pixel?
     if (x1 == x2)
 	return;				
+
+    // Already hidden behind solid walls? Neither clip
+    // function would find anything to draw.
+    if (R_ColumnsSolid (x1, x2-1))
+	return;
 	
     backsector = line->backsector;
 
@@ -371,7 +547,7 @@ int	checkcoord[12][4] =
 };
 
 
-boolean R_CheckBBox (fixed_t*	bspcoord)
+boolean R_CheckBBox (short*	bspcoord)
 {
     int			boxx;
     int			boxy;
@@ -386,24 +562,22 @@ boolean R_CheckBBox (fixed_t*	bspcoord)
     angle_t		angle2;
     angle_t		span;
     angle_t		tspan;
-    
-    cliprange_t*	start;
 
     int			sx1;
     int			sx2;
     
     // Find the corners of the box
     // that define the edges from current viewpoint.
-    if (viewx <= bspcoord[BOXLEFT])
+    if (viewx <= bspcoord[BOXLEFT]<<FRACBITS)
 	boxx = 0;
-    else if (viewx < bspcoord[BOXRIGHT])
+    else if (viewx < bspcoord[BOXRIGHT]<<FRACBITS)
 	boxx = 1;
     else
 	boxx = 2;
 		
-    if (viewy >= bspcoord[BOXTOP])
+    if (viewy >= bspcoord[BOXTOP]<<FRACBITS)
 	boxy = 0;
-    else if (viewy > bspcoord[BOXBOTTOM])
+    else if (viewy > bspcoord[BOXBOTTOM]<<FRACBITS)
 	boxy = 1;
     else
 	boxy = 2;
@@ -412,10 +586,10 @@ boolean R_CheckBBox (fixed_t*	bspcoord)
     if (boxpos == 5)
 	return true;
 	
-    x1 = bspcoord[checkcoord[boxpos][0]];
-    y1 = bspcoord[checkcoord[boxpos][1]];
-    x2 = bspcoord[checkcoord[boxpos][2]];
-    y2 = bspcoord[checkcoord[boxpos][3]];
+    x1 = bspcoord[checkcoord[boxpos][0]]<<FRACBITS;
+    y1 = bspcoord[checkcoord[boxpos][1]]<<FRACBITS;
+    x2 = bspcoord[checkcoord[boxpos][2]]<<FRACBITS;
+    y2 = bspcoord[checkcoord[boxpos][3]]<<FRACBITS;
     
     // check clip list for an open space
     angle1 = R_PointToAngle (x1, y1) - viewangle;
@@ -426,6 +600,9 @@ boolean R_CheckBBox (fixed_t*	bspcoord)
     // Sitting on a line?
     if (span >= ANG180)
 	return true;
+
+    if (SCREENFULL)
+	return false;
     
     tspan = angle1 + clipangle;
 
@@ -464,19 +641,9 @@ boolean R_CheckBBox (fixed_t*	bspcoord)
     if (sx1 == sx2)
 	return false;			
     sx2--;
-	
-    start = solidsegs;
-    while (start->last < sx2)
-	start++;
-    
-    if (sx1 >= start->first
-	&& sx2 <= start->last)
-    {
-	// The clippost contains the new span.
-	return false;
-    }
 
-    return true;
+    // Solid walls already cover the whole span?
+    return !R_ColumnsSolid (sx1, sx2);
 }
 
 
@@ -506,6 +673,14 @@ void R_Subsector (int num)
     count = sub->numlines;
     line = &segs[sub->firstline];
 
+    if (SCREENFULL)
+    {
+	// Walls and planes cannot show any more, but sprites
+	//  of a sector reached now may still reach into view.
+	R_AddSprites (frontsector);
+	return;
+    }
+
     if (frontsector->floorheight < viewz)
     {
 	floorplane = R_FindPlane (frontsector->floorheight,
@@ -540,34 +715,51 @@ void R_Subsector (int num)
 //
 // RenderBSPNode
 // Renders all subsectors below a given node,
-//  traversing subtree recursively.
+//  front to back.
 // Just call with BSP root.
+// Each node passed on the way down is pushed on bspstack
+//  with the side the view point is on, to come back to
+//  for the back space once the front space is done.
 void R_RenderBSPNode (int bspnum)
 {
     node_t*	bsp;
+    int*	sp;
     int		side;
 
-    // Found a subsector?
-    if (bspnum & NF_SUBSECTOR)
+    sp = bspstack;
+
+    for (;;)
     {
+	// Divide front space down to a subsector.
+	while (!(bspnum & NF_SUBSECTOR))
+	{
+	    bsp = &nodes[bspnum];
+
+	    // Decide which side the view point is on.
+	    side = R_PointOnSide (viewx, viewy, bsp);
+
+	    *sp++ = (bspnum << 1) | side;
+	    bspnum = bsp->children[side];
+	}
+
 	if (bspnum == -1)			
 	    R_Subsector (0);
 	else
 	    R_Subsector (bspnum&(~NF_SUBSECTOR));
-	return;
-    }
-		
-    bsp = &nodes[bspnum];
-    
-    // Decide which side the view point is on.
-    side = R_PointOnSide (viewx, viewy, bsp);
 
-    // Recursively divide front space.
-    R_RenderBSPNode (bsp->children[side]); 
+	// Back up to the nearest back space that might be visible.
+	do
+	{
+	    if (sp == bspstack)
+		return;
+
+	    sp--;
+	    bspnum = *sp >> 1;
+	    side = (*sp & 1) ^ 1;
+	} while (!R_CheckBBox (nodeboxes[bspnum].bbox[side]));
 
-    // Possibly divide back space.
-    if (R_CheckBBox (bsp->bbox[side^1]))	
-	R_RenderBSPNode (bsp->children[side^1]);
+	bspnum = nodes[bspnum].children[side];
+    }
 }
 
 
@@ -39,9 +39,14 @@ extern boolean		markceiling;
 
 extern boolean		skymap;
 
-extern drawseg_t	drawsegs[MAXDRAWSEGS];
+extern drawseg_t*	drawsegs;
+extern int		maxdrawsegs;
 extern drawseg_t*	ds_p;
 
+extern int		peakdrawsegs;
+extern int		maxsolidsegs;
+extern int		peaksolidsegs;
+
 extern lighttable_t**	hscalelight;
 extern lighttable_t**	vscalelight;
 extern lighttable_t**	dscalelight;
@@ -53,6 +58,7 @@ typedef void (*drawfunc_t) (int start, int stop);
 // BSP?
 void R_ClearClipSegs (void);
 void R_ClearDrawSegs (void);
+void R_GrowDrawSegs (void);
 
 
 void R_RenderBSPNode (int bspnum);
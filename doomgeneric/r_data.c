@@ -19,15 +19,19 @@
 
 #include <stdio.h>
 
+#include "d_main.h"
 #include "deh_main.h"
 #include "i_swap.h"
 #include "i_system.h"
+#include "i_timer.h"
 #include "z_zone.h"
 
 
 #include "w_wad.h"
+#include "w_prefetch.h"
 
 #include "doomdef.h"
+#include "m_argv.h"
 #include "m_misc.h"
 #include "r_local.h"
 #include "p_local.h"
@@ -151,6 +155,30 @@ short**			texturecolumnlump;
 unsigned short**	texturecolumnofs;
 byte**			texturecomposite;
 
+// Column data pointers for each texture, resolved on first use
+//  in a level. The patches and composites they point into are
+//  held at PU_LEVEL, so the tables go away with them.
+static byte***		texturecolumns;
+
+// Composites of the textures a level uses, built together at
+//  level start. Each starts on an 8 byte boundary.
+#define COMPOSITEALIGN(n)	(((n) + 7) & ~7)
+
+static byte*		texturearena;
+static int		texturearenasize;
+
+// With -lazyinit, a texture's column lookup is generated when
+//  a level first uses it, and a sprite lump's sizes when it is
+//  first drawn, rather than all of them at startup.
+static boolean		lazyinit;
+static byte*		texturelookupdone;
+
+static void R_CheckLookup (int texnum);
+
+// Lumps held at PU_LEVEL by a column table, [numlumps].
+// Allocated at PU_LEVEL too, so it is cleared every level.
+static byte*		lockedlumps;
+
 // for global animation
 int*		flattranslation;
 int*		texturetranslation;
@@ -159,6 +187,7 @@ int*		texturetranslation;
 fixed_t*	spritewidth;	
 fixed_t*	spriteoffset;
 fixed_t*	spritetopoffset;
+byte*		spritelumpready;
 
 lighttable_t	*colormaps;
 
@@ -218,14 +247,13 @@ R_DrawColumnInCache
 
 
 //
-// R_GenerateComposite
+// R_CompositeTexture
 // Using the texture definition,
-//  the composite texture is created from the patches,
-//  and each column is cached.
+//  the composite texture is drawn into block
+//  from the patches.
 //
-void R_GenerateComposite (int texnum)
+static void R_CompositeTexture (int texnum, byte* block)
 {
-    byte*		block;
     texture_t*		texture;
     texpatch_t*		patch;	
     patch_t*		realpatch;
@@ -239,10 +267,6 @@ void R_GenerateComposite (int texnum)
 	
     texture = textures[texnum];
 
-    block = Z_Malloc (texturecompositesize[texnum],
-		      PU_STATIC, 
-		      &texturecomposite[texnum]);	
-
     collump = texturecolumnlump[texnum];
     colofs = texturecolumnofs[texnum];
     
@@ -253,7 +277,12 @@ void R_GenerateComposite (int texnum)
 	 i<texture->patchcount;
 	 i++, patch++)
     {
-	realpatch = W_CacheLumpNum (patch->patch, PU_CACHE);
+	// Do not let a patch locked by a column table become purgable.
+	if (lockedlumps != NULL && lockedlumps[patch->patch])
+	    realpatch = W_CacheLumpNum (patch->patch, PU_LEVEL);
+	else
+	    realpatch = W_CacheLumpNum (patch->patch, PU_CACHE);
+
 	x1 = patch->originx;
 	x2 = x1 + SHORT(realpatch->width);
 
@@ -280,6 +309,24 @@ void R_GenerateComposite (int texnum)
 	}
 						
     }
+}
+
+
+
+//
+// R_GenerateComposite
+// Creates the composite of a texture the level
+//  did not have at its start, and caches it.
+//
+void R_GenerateComposite (int texnum)
+{
+    byte*		block;
+
+    block = Z_Malloc (texturecompositesize[texnum],
+		      PU_STATIC, 
+		      &texturecomposite[texnum]);	
+
+    R_CompositeTexture (texnum, block);
 
     // Now that the texture has been built in column cache,
     //  it is purgable from zone memory.
@@ -288,6 +335,88 @@ void R_GenerateComposite (int texnum)
 
 
 
+//
+// R_CompositeLevelTextures
+// Builds the composites of all the textures a level uses
+//  in one block at level start, so that none is generated
+//  in the middle of a frame.
+//
+static void R_CompositeLevelTextures (char* texturepresent)
+{
+    int		starttime;
+    int		size;
+    int		count;
+    int		i;
+
+    size = 0;
+
+    for (i=0 ; i<numtextures ; i++)
+    {
+	if (!texturepresent[i])
+	    continue;
+
+	R_CheckLookup (i);
+
+	if (!texturecomposite[i])
+	    size += COMPOSITEALIGN(texturecompositesize[i]);
+    }
+
+    if (size == 0)
+	return;
+
+    starttime = I_GetTimeMS ();
+
+    texturearena = Z_Malloc (size, PU_STATIC, &texturearena);
+    texturearenasize = size;
+
+    size = 0;
+    count = 0;
+
+    for (i=0 ; i<numtextures ; i++)
+    {
+	if (!texturepresent[i] || texturecomposite[i]
+	 || !texturecompositesize[i])
+	    continue;
+
+	texturecomposite[i] = texturearena + size;
+	R_CompositeTexture (i, texturecomposite[i]);
+
+	size += COMPOSITEALIGN(texturecompositesize[i]);
+	count++;
+    }
+
+    if (devparm)
+    {
+	printf ("R_PrecacheLevel: %i composite textures, %i bytes "
+		"in %i ms\n", count, size, I_GetTimeMS () - starttime);
+    }
+}
+
+
+//
+// R_FreeTextureArena
+// Called at level setup, before the last level's blocks
+//  are freed. The level's composites go in one Z_Free.
+//
+void R_FreeTextureArena (void)
+{
+    int		i;
+
+    if (texturearena == NULL)
+	return;
+
+    for (i=0 ; i<numtextures ; i++)
+    {
+	if (texturecomposite[i] >= texturearena
+	 && texturecomposite[i] < texturearena + texturearenasize)
+	    texturecomposite[i] = NULL;
+    }
+
+    Z_Free (texturearena);
+}
+
+
+
 //
 // R_GenerateLookup
 //
@@ -305,6 +434,7 @@ void R_GenerateLookup (int texnum)
     unsigned short*	colofs;
 	
     texture = textures[texnum];
+    texturelookupdone[texnum] = 1;
 
     // Composited texture not created yet.
     texturecomposite[texnum] = 0;
@@ -325,7 +455,11 @@ void R_GenerateLookup (int texnum)
 	 i<texture->patchcount;
 	 i++, patch++)
     {
-	realpatch = W_CacheLumpNum (patch->patch, PU_CACHE);
+	// Generated in a level with -lazyinit: as in R_CompositeTexture.
+	if (lockedlumps != NULL && lockedlumps[patch->patch])
+	    realpatch = W_CacheLumpNum (patch->patch, PU_LEVEL);
+	else
+	    realpatch = W_CacheLumpNum (patch->patch, PU_CACHE);
 	x1 = patch->originx;
 	x2 = x1 + SHORT(realpatch->width);
 	
@@ -374,6 +508,67 @@ void R_GenerateLookup (int texnum)
 }
 
 
+//
+// R_CheckLookup
+// Generates the column lookup of a texture
+//  that -lazyinit left until it was used.
+//
+static void R_CheckLookup (int texnum)
+{
+    if (!texturelookupdone[texnum])
+	R_GenerateLookup (texnum);
+}
+
+
+
+
+//
+// R_GenerateColumns
+// Resolves every column of a texture to its data and locks
+//  the patches and composite that data lives in for the level.
+//
+static byte** R_GenerateColumns (int tex)
+{
+    byte**	columns;
+    int		width;
+    int		lump;
+    int		col;
+
+    if (lockedlumps == NULL)
+    {
+	lockedlumps = Z_Malloc (numlumps, PU_LEVEL, &lockedlumps);
+	memset (lockedlumps, 0, numlumps);
+    }
+
+    R_CheckLookup (tex);
+
+    width = texturewidthmask[tex] + 1;
+    columns = Z_Malloc (width * sizeof(*columns), PU_LEVEL,
+			&texturecolumns[tex]);
+
+    for (col=0 ; col<width ; col++)
+    {
+	lump = texturecolumnlump[tex][col];
+
+	if (lump > 0)
+	{
+	    lockedlumps[lump] = 1;
+	    columns[col] = (byte *) W_CacheLumpNum (lump, PU_LEVEL)
+			 + texturecolumnofs[tex][col];
+	    continue;
+	}
+
+	if (!texturecomposite[tex])
+	{
+	    R_GenerateComposite (tex);
+	    Z_ChangeTag (texturecomposite[tex], PU_LEVEL);
+	}
+
+	columns[col] = texturecomposite[tex] + texturecolumnofs[tex][col];
+    }
+
+    return columns;
+}
 
 
 //
@@ -384,20 +579,14 @@ R_GetColumn
 ( int		tex,
   int		col )
 {
-    int		lump;
-    int		ofs;
-	
-    col &= texturewidthmask[tex];
-    lump = texturecolumnlump[tex][col];
-    ofs = texturecolumnofs[tex][col];
-    
-    if (lump > 0)
-	return (byte *)W_CacheLumpNum(lump,PU_CACHE)+ofs;
+    byte**	columns;
 
-    if (!texturecomposite[tex])
-	R_GenerateComposite (tex);
+    columns = texturecolumns[tex];
 
-    return texturecomposite[tex] + ofs;
+    if (columns == NULL)
+	columns = R_GenerateColumns (tex);
+
+    return columns[col & texturewidthmask[tex]];
 }
 
 
@@ -523,9 +712,13 @@ void R_InitTextures (void)
     texturecolumnlump = Z_Malloc (numtextures * sizeof(*texturecolumnlump), PU_STATIC, 0);
     texturecolumnofs = Z_Malloc (numtextures * sizeof(*texturecolumnofs), PU_STATIC, 0);
     texturecomposite = Z_Malloc (numtextures * sizeof(*texturecomposite), PU_STATIC, 0);
+    texturecolumns = Z_Malloc (numtextures * sizeof(*texturecolumns), PU_STATIC, 0);
+    memset (texturecolumns, 0, numtextures * sizeof(*texturecolumns));
     texturecompositesize = Z_Malloc (numtextures * sizeof(*texturecompositesize), PU_STATIC, 0);
     texturewidthmask = Z_Malloc (numtextures * sizeof(*texturewidthmask), PU_STATIC, 0);
     textureheight = Z_Malloc (numtextures * sizeof(*textureheight), PU_STATIC, 0);
+    texturelookupdone = Z_Malloc (numtextures, PU_STATIC, 0);
+    memset (texturelookupdone, 0, numtextures);
 
     totalwidth = 0;
     
@@ -613,8 +806,11 @@ void R_InitTextures (void)
     
     // Precalculate whatever possible.	
 
-    for (i=0 ; i<numtextures ; i++)
-	R_GenerateLookup (i);
+    if (!lazyinit)
+    {
+	for (i=0 ; i<numtextures ; i++)
+	    R_GenerateLookup (i);
+    }
     
     // Create translation table for global animation.
     texturetranslation = Z_Malloc ((numtextures+1)*sizeof(*texturetranslation), PU_STATIC, 0);
@@ -646,6 +842,24 @@ void R_InitFlats (void)
 }
 
 
+//
+// R_InitSpriteLump
+// Reads the width and offsets of a sprite lump
+//  into the tables.
+//
+void R_InitSpriteLump (int lump)
+{
+    patch_t	*patch;
+
+    patch = W_CacheLumpNum (firstspritelump+lump, PU_CACHE);
+    spritewidth[lump] = SHORT(patch->width)<<FRACBITS;
+    spriteoffset[lump] = SHORT(patch->leftoffset)<<FRACBITS;
+    spritetopoffset[lump] = SHORT(patch->topoffset)<<FRACBITS;
+    spritelumpready[lump] = 1;
+}
+
+
+
 //
 // R_InitSpriteLumps
 // Finds the width and hoffset of all sprites in the wad,
@@ -655,7 +869,6 @@ void R_InitFlats (void)
 void R_InitSpriteLumps (void)
 {
     int		i;
-    patch_t	*patch;
 	
     firstspritelump = W_GetNumForName (DEH_String("S_START")) + 1;
     lastspritelump = W_GetNumForName (DEH_String("S_END")) - 1;
@@ -664,16 +877,18 @@ void R_InitSpriteLumps (void)
     spritewidth = Z_Malloc (numspritelumps*sizeof(*spritewidth), PU_STATIC, 0);
     spriteoffset = Z_Malloc (numspritelumps*sizeof(*spriteoffset), PU_STATIC, 0);
     spritetopoffset = Z_Malloc (numspritelumps*sizeof(*spritetopoffset), PU_STATIC, 0);
+    spritelumpready = Z_Malloc (numspritelumps, PU_STATIC, 0);
+    memset (spritelumpready, 0, numspritelumps);
+
+    if (lazyinit)
+	return;
 	
     for (i=0 ; i< numspritelumps ; i++)
     {
 	if (!(i&63))
 	    printf (".");
 
-	patch = W_CacheLumpNum (firstspritelump+i, PU_CACHE);
-	spritewidth[i] = SHORT(patch->width)<<FRACBITS;
-	spriteoffset[i] = SHORT(patch->leftoffset)<<FRACBITS;
-	spritetopoffset[i] = SHORT(patch->topoffset)<<FRACBITS;
+	R_InitSpriteLump (i);
     }
 }
 
@@ -702,12 +917,27 @@ void R_InitColormaps (void)
 //
 void R_InitData (void)
 {
+    //!
+    // @category obscure
+    //
+    // Work out how each wall texture is put together from its
+    // patches when a level first uses it, and read the size of
+    // each sprite when it is first drawn, instead of doing all
+    // of them at startup.
+    //
+
+    lazyinit = M_CheckParm ("-lazyinit") > 0;
+
+    D_StartupPhase ("R_InitTextures");
     R_InitTextures ();
     printf (".");
+    D_StartupPhase ("R_InitFlats");
     R_InitFlats ();
     printf (".");
+    D_StartupPhase ("R_InitSpriteLumps");
     R_InitSpriteLumps ();
     printf (".");
+    D_StartupPhase ("R_InitColormaps");
     R_InitColormaps ();
 }
 
@@ -789,6 +1019,61 @@ int	R_TextureNumForName (char* name)
 
 
 
+//
+// R_LevelTextures
+// Marks the textures the level uses, in a table
+//  to be freed by the caller.
+//
+static char* R_LevelTextures (void)
+{
+    char*	texturepresent;
+    int		i;
+
+    texturepresent = Z_Malloc(numtextures, PU_STATIC, NULL);
+    memset (texturepresent,0, numtextures);
+	
+    for (i=0 ; i<numsides ; i++)
+    {
+	texturepresent[sides[i].toptexture] = 1;
+	texturepresent[sides[i].midtexture] = 1;
+	texturepresent[sides[i].bottomtexture] = 1;
+    }
+
+    // Sky texture is always present.
+    // Note that F_SKY1 is the name used to
+    //  indicate a sky floor/ceiling as a flat,
+    //  while the sky texture is stored like
+    //  a wall texture, with an episode dependend
+    //  name.
+    texturepresent[skytexture] = 1;
+
+    return texturepresent;
+}
+
+
+//
+// R_LevelLookups
+// Makes the lookups -lazyinit left for the textures the level
+//  uses, for when it is not precached, as in demos. Otherwise
+//  they would be made in the middle of a frame.
+//
+void R_LevelLookups (void)
+{
+    char*	texturepresent;
+    int		i;
+
+    texturepresent = R_LevelTextures ();
+
+    for (i=0 ; i<numtextures ; i++)
+    {
+	if (texturepresent[i])
+	    R_CheckLookup (i);
+    }
+
+    Z_Free(texturepresent);
+}
+
+
 //
 // R_PrecacheLevel
 // Preloads all relevant graphics for the level.
@@ -813,7 +1098,10 @@ void R_PrecacheLevel (void)
     spriteframe_t*	sf;
 
     if (demoplayback)
+    {
+	R_LevelLookups ();
 	return;
+    }
     
     // Precache flats.
     flatpresent = Z_Malloc(numflats, PU_STATIC, NULL);
@@ -840,23 +1128,7 @@ void R_PrecacheLevel (void)
     Z_Free(flatpresent);
     
     // Precache textures.
-    texturepresent = Z_Malloc(numtextures, PU_STATIC, NULL);
-    memset (texturepresent,0, numtextures);
-	
-    for (i=0 ; i<numsides ; i++)
-    {
-	texturepresent[sides[i].toptexture] = 1;
-	texturepresent[sides[i].midtexture] = 1;
-	texturepresent[sides[i].bottomtexture] = 1;
-    }
-
-    // Sky texture is always present.
-    // Note that F_SKY1 is the name used to
-    //  indicate a sky floor/ceiling as a flat,
-    //  while the sky texture is stored like
-    //  a wall texture, with an episode dependend
-    //  name.
-    texturepresent[skytexture] = 1;
+    texturepresent = R_LevelTextures ();
 	
     texturememory = 0;
     for (i=0 ; i<numtextures ; i++)
@@ -874,6 +1146,8 @@ void R_PrecacheLevel (void)
 	}
     }
 
+    R_CompositeLevelTextures (texturepresent);
+
     Z_Free(texturepresent);
     
     // Precache sprites.
@@ -899,7 +1173,7 @@ void R_PrecacheLevel (void)
 	    {
 		lump = firstspritelump + sf->lump[k];
 		spritememory += lumpinfo[lump].size;
-		W_CacheLumpNum(lump , PU_CACHE);
+		V_CachePatchNum(lump, PU_CACHE);
 	    }
 	}
     }
@@ -909,4 +1183,49 @@ void R_PrecacheLevel (void)
 
 
 
+//
+// R_PrefetchTexture
+// Reads ahead the patches of a wall texture, by name.
+// Runs on the prefetch thread.
+//
+void R_PrefetchTexture (char* name)
+{
+    texture_t*		texture;
+    int			num;
+    int			j;
+
+    num = R_CheckTextureNumForName (name);
+
+    if (num == -1)
+	return;
+
+    texture = textures[num];
+
+    for (j=0 ; j<texture->patchcount ; j++)
+	W_WarmLump (texture->patches[j].patch);
+}
+
+
+
+//
+// R_PrefetchSprite
+// Reads ahead every frame of a sprite.
+// Runs on the prefetch thread.
+//
+void R_PrefetchSprite (int sprite)
+{
+    spriteframe_t*	sf;
+    int			j;
+    int			k;
+
+    for (j=0 ; j<sprites[sprite].numframes ; j++)
+    {
+	sf = &sprites[sprite].spriteframes[j];
+	for (k=0 ; k<8 ; k++)
+	    W_WarmLump (firstspritelump + sf->lump[k]);
+    }
+}
+
+
+
 
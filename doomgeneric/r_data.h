@@ -35,6 +35,11 @@ R_GetColumn
 // I/O, setting up the stuff.
 void R_InitData (void);
 void R_PrecacheLevel (void);
+void R_LevelLookups (void);
+void R_PrefetchTexture (char* name);
+void R_PrefetchSprite (int sprite);
+void R_FreeTextureArena (void);
+void R_InitSpriteLump (int lump);
 
 
 // Retrieval.
@@ -127,6 +127,11 @@ typedef	struct
 
     int			linecount;
     struct line_s**	lines;	// [linecount] size
+
+    // Heights before the last tic was run,
+    // for drawing frames in between tics.
+    fixed_t	oldfloorheight;
+    fixed_t	oldceilingheight;
     
 } sector_t;
 
@@ -257,23 +262,31 @@ typedef struct
 
 //
 // BSP node.
+// Node lumps hold whole map units, so these are kept as the
+// 16-bit values read from the map. The partition line and the
+// children, which every walk of the tree reads, are kept apart
+// from the bounding boxes, which only the renderer needs.
 //
 typedef struct
 {
-    // Partition line.
-    fixed_t	x;
-    fixed_t	y;
-    fixed_t	dx;
-    fixed_t	dy;
-
-    // Bounding box for each child.
-    fixed_t	bbox[2][4];
+    // Partition line, in map units.
+    short	x;
+    short	y;
+    short	dx;
+    short	dy;
 
     // If NF_SUBSECTOR its a subsector.
     unsigned short children[2];
     
 } node_t;
 
+// Bounding box for each child of a node, in map units.
+typedef struct
+{
+    short	bbox[2][4];
+
+} nodebox_t;
+
 
 
 
@@ -428,17 +441,11 @@ typedef struct
   int			minx;
   int			maxx;
   
-  // leave pads for [minx-1]/[maxx+1]
-  
-  byte		pad1;
-  // Here lies the rub for all
-  //  dynamic resize/change of resolution.
-  byte		top[SCREENWIDTH];
-  byte		pad2;
-  byte		pad3;
-  // See above.
-  byte		bottom[SCREENWIDTH];
-  byte		pad4;
+  // SCREENWIDTH entries each, allocated by R_InitPlanes
+  //  with pads for [minx-1]/[maxx+1].
+  // 0xffff in top marks an unused column.
+  unsigned short*	top;
+  unsigned short*	bottom;
 
 } visplane_t;
 
@@ -29,6 +29,7 @@
 #include "w_wad.h"
 
 #include "r_local.h"
+#include "r_sky.h"
 
 // Needs access to LFB (guess what).
 #include "v_video.h"
@@ -37,12 +38,8 @@
 #include "doomstat.h"
 
 
-// ?
-#define MAXWIDTH			1120
-#define MAXHEIGHT			832
-
 // status bar height at bottom of screen
-#define SBARHEIGHT		32
+#define SBARHEIGHT		(32 << hires)
 
 //
 // All drawing to the view buffer is accomplished in this file.
@@ -60,8 +57,8 @@ int		scaledviewwidth;
 int		viewheight;
 int		viewwindowx;
 int		viewwindowy; 
-byte*		ylookup[MAXHEIGHT]; 
-int		columnofs[MAXWIDTH]; 
+byte**		ylookup; 
+int*		columnofs; 
 
 // Color tables for different players,
 //  translate a limited part to another
@@ -79,15 +76,15 @@ static byte *background_buffer = NULL;
 // R_DrawColumn
 // Source is the top of the column to scale.
 //
-lighttable_t*		dc_colormap; 
-int			dc_x; 
-int			dc_yl; 
-int			dc_yh; 
-fixed_t			dc_iscale; 
-fixed_t			dc_texturemid;
+R_THREADLOCAL lighttable_t*	dc_colormap; 
+R_THREADLOCAL int		dc_x; 
+R_THREADLOCAL int		dc_yl; 
+R_THREADLOCAL int		dc_yh; 
+R_THREADLOCAL fixed_t		dc_iscale; 
+R_THREADLOCAL fixed_t		dc_texturemid;
 
 // first pixel in a column (possibly virtual) 
-byte*			dc_source;		
+R_THREADLOCAL byte*		dc_source;		
 
 // just for profiling 
 int			dccount;
@@ -105,6 +102,7 @@ void R_DrawColumn (void)
     byte*		dest; 
     fixed_t		frac;
     fixed_t		fracstep;	 
+    int			pitch;
  
     count = dc_yh - dc_yl; 
 
@@ -123,6 +121,7 @@ void R_DrawColumn (void)
     // Use ylookup LUT to avoid multiply with ScreenWidth.
     // Use columnofs LUT for subwindows? 
     dest = ylookup[dc_yl] + columnofs[dc_x];  
+    pitch = SCREENYSTEP;
 
     // Determine scaling,
     //  which is the only mapping to be done.
@@ -138,7 +137,7 @@ void R_DrawColumn (void)
 	//  using a lighting/special effects LUT.
 	*dest = dc_colormap[dc_source[(frac>>FRACBITS)&127]];
 	
-	dest += SCREENWIDTH; 
+	dest += pitch; 
 	frac += fracstep;
 	
     } while (count--); 
@@ -212,6 +211,7 @@ void R_DrawColumnLow (void)
     byte*		dest2;
     fixed_t		frac;
     fixed_t		fracstep;	 
+    int			pitch;
     int                 x;
  
     count = dc_yh - dc_yl; 
@@ -235,6 +235,7 @@ void R_DrawColumnLow (void)
     
     dest = ylookup[dc_yl] + columnofs[x];
     dest2 = ylookup[dc_yl] + columnofs[x+1];
+    pitch = SCREENYSTEP;
     
     fracstep = dc_iscale; 
     frac = dc_texturemid + (dc_yl-centery)*fracstep;
@@ -243,8 +244,8 @@ void R_DrawColumnLow (void)
     {
 	// Hack. Does not work corretly.
 	*dest2 = *dest = dc_colormap[dc_source[(frac>>FRACBITS)&127]];
-	dest += SCREENWIDTH;
-	dest2 += SCREENWIDTH;
+	dest += pitch;
+	dest2 += pitch;
 	frac += fracstep; 
 
     } while (count--);
@@ -255,7 +256,9 @@ void R_DrawColumnLow (void)
 // Spectre/Invisibility.
 //
 #define FUZZTABLE		50 
-#define FUZZOFF	(SCREENWIDTH)
+
+// One row up or down; R_InitBuffer scales these by SCREENYSTEP.
+#define FUZZOFF	(1)
 
 
 int	fuzzoffset[FUZZTABLE] =
@@ -269,7 +272,25 @@ int	fuzzoffset[FUZZTABLE] =
     FUZZOFF,FUZZOFF,-FUZZOFF,FUZZOFF,FUZZOFF,-FUZZOFF,FUZZOFF 
 }; 
 
-int	fuzzpos = 0; 
+R_THREADLOCAL int	fuzzpos = 0; 
+
+
+//
+// R_SkipFuzzColumn
+// Moves fuzzpos on as R_DrawFuzzColumn (or its low detail
+// version) would for dc_yl to dc_yh, without drawing anything.
+//
+void R_SkipFuzzColumn (void)
+{
+    int		yl;
+    int		yh;
+
+    yl = dc_yl ? dc_yl : 1;
+    yh = dc_yh == viewheight-1 ? viewheight - 2 : dc_yh;
+
+    if (yh >= yl)
+	fuzzpos = (fuzzpos + yh - yl + 1) % FUZZTABLE;
+}
 
 
 //
@@ -280,12 +301,18 @@ int	fuzzpos = 0;
 //  could create the SHADOW effect,
 //  i.e. spectres and invisible players.
 //
+// The offsets are taken in runs up to the end of the table,
+//  so fuzzpos only wraps between runs. A pixel can read the
+//  row just written above it, so rows are still done in order.
+//
 void R_DrawFuzzColumn (void) 
 { 
     int			count; 
+    int			run;
     byte*		dest; 
-    fixed_t		frac;
-    fixed_t		fracstep;	 
+    byte*		fuzzmap;
+    int*		offset;
+    int			pitch;
 
     // Adjust borders. Low... 
     if (!dc_yl) 
@@ -295,10 +322,10 @@ void R_DrawFuzzColumn (void)
     if (dc_yh == viewheight-1) 
 	dc_yh = viewheight - 2; 
 		 
-    count = dc_yh - dc_yl; 
+    count = dc_yh - dc_yl + 1; 
 
     // Zero length.
-    if (count < 0) 
+    if (count <= 0) 
 	return; 
 
 #ifdef RANGECHECK 
@@ -311,30 +338,50 @@ void R_DrawFuzzColumn (void)
 #endif
     
     dest = ylookup[dc_yl] + columnofs[dc_x];
-
-    // Looks familiar.
-    fracstep = dc_iscale; 
-    frac = dc_texturemid + (dc_yl-centery)*fracstep; 
+    pitch = SCREENYSTEP;
 
     // Looks like an attempt at dithering,
     //  using the colormap #6 (of 0-31, a bit
     //  brighter than average).
-    do 
+    fuzzmap = colormaps + 6*256;
+
+    while (count > 0)
     {
+	run = FUZZTABLE - fuzzpos;
+
+	if (run > count)
+	    run = count;
+
+	count -= run;
+	offset = fuzzoffset + fuzzpos;
+
+	fuzzpos += run;
+
+	if (fuzzpos == FUZZTABLE)
+	    fuzzpos = 0;
+
 	// Lookup framebuffer, and retrieve
 	//  a pixel that is either one column
 	//  left or right of the current one.
 	// Add index from colormap to index.
-	*dest = colormaps[6*256+dest[fuzzoffset[fuzzpos]]]; 
-
-	// Clamp table lookup index.
-	if (++fuzzpos == FUZZTABLE) 
-	    fuzzpos = 0;
-	
-	dest += SCREENWIDTH;
+	while (run >= 4)
+	{
+	    dest[0] = fuzzmap[dest[offset[0]]];
+	    dest[pitch] = fuzzmap[dest[pitch+offset[1]]];
+	    dest[pitch*2] = fuzzmap[dest[pitch*2+offset[2]]];
+	    dest[pitch*3] = fuzzmap[dest[pitch*3+offset[3]]];
+
+	    dest += pitch*4;
+	    offset += 4;
+	    run -= 4;
+	}
 
-	frac += fracstep; 
-    } while (count--); 
+	while (run--)
+	{
+	    *dest = fuzzmap[dest[*offset++]];
+	    dest += pitch;
+	}
+    }
 } 
 
 // low detail mode version
@@ -342,10 +389,12 @@ void R_DrawFuzzColumn (void)
 void R_DrawFuzzColumnLow (void) 
 { 
     int			count; 
+    int			run;
     byte*		dest; 
     byte*		dest2; 
-    fixed_t		frac;
-    fixed_t		fracstep;	 
+    byte*		fuzzmap;
+    int*		offset;
+    int			pitch;
     int x;
 
     // Adjust borders. Low... 
@@ -356,10 +405,10 @@ void R_DrawFuzzColumnLow (void)
     if (dc_yh == viewheight-1) 
 	dc_yh = viewheight - 2; 
 		 
-    count = dc_yh - dc_yl; 
+    count = dc_yh - dc_yl + 1; 
 
     // Zero length.
-    if (count < 0) 
+    if (count <= 0) 
 	return; 
 
     // low detail mode, need to multiply by 2
@@ -377,32 +426,45 @@ void R_DrawFuzzColumnLow (void)
     
     dest = ylookup[dc_yl] + columnofs[x];
     dest2 = ylookup[dc_yl] + columnofs[x+1];
+    pitch = SCREENYSTEP;
+    fuzzmap = colormaps + 6*256;
 
-    // Looks familiar.
-    fracstep = dc_iscale; 
-    frac = dc_texturemid + (dc_yl-centery)*fracstep; 
-
-    // Looks like an attempt at dithering,
-    //  using the colormap #6 (of 0-31, a bit
-    //  brighter than average).
-    do 
+    while (count > 0)
     {
-	// Lookup framebuffer, and retrieve
-	//  a pixel that is either one column
-	//  left or right of the current one.
-	// Add index from colormap to index.
-	*dest = colormaps[6*256+dest[fuzzoffset[fuzzpos]]]; 
-	*dest2 = colormaps[6*256+dest2[fuzzoffset[fuzzpos]]]; 
+	run = FUZZTABLE - fuzzpos;
+
+	if (run > count)
+	    run = count;
+
+	count -= run;
+	offset = fuzzoffset + fuzzpos;
 
-	// Clamp table lookup index.
-	if (++fuzzpos == FUZZTABLE) 
+	fuzzpos += run;
+
+	if (fuzzpos == FUZZTABLE)
 	    fuzzpos = 0;
-	
-	dest += SCREENWIDTH;
-	dest2 += SCREENWIDTH;
 
-	frac += fracstep; 
-    } while (count--); 
+	while (run >= 2)
+	{
+	    dest[0] = fuzzmap[dest[offset[0]]];
+	    dest2[0] = fuzzmap[dest2[offset[0]]];
+	    dest[pitch] = fuzzmap[dest[pitch+offset[1]]];
+	    dest2[pitch] = fuzzmap[dest2[pitch+offset[1]]];
+
+	    dest += pitch*2;
+	    dest2 += pitch*2;
+	    offset += 2;
+	    run -= 2;
+	}
+
+	if (run)
+	{
+	    *dest = fuzzmap[dest[*offset]];
+	    *dest2 = fuzzmap[dest2[*offset]];
+	    dest += pitch;
+	    dest2 += pitch;
+	}
+    }
 } 
  
   
@@ -418,18 +480,44 @@ void R_DrawFuzzColumnLow (void)
 //  of the BaronOfHell, the HellKnight, uses
 //  identical sprites, kinda brightened up.
 //
-byte*	dc_translation;
+R_THREADLOCAL byte*	dc_translation;
 byte*	translationtables;
 
+// The translation and colormap of the last translated column,
+//  composed into one table. A sprite's columns all share them.
+static R_THREADLOCAL byte	translatedmap[256];
+static R_THREADLOCAL byte*	translatedcolormap;
+static R_THREADLOCAL byte*	translatedtable;
+
+static byte* R_TranslatedMap (void)
+{
+    int		i;
+
+    if (dc_colormap != translatedcolormap
+     || dc_translation != translatedtable)
+    {
+	for (i=0 ; i<256 ; i++)
+	    translatedmap[i] = dc_colormap[dc_translation[i]];
+
+	translatedcolormap = dc_colormap;
+	translatedtable = dc_translation;
+    }
+
+    return translatedmap;
+}
+
 void R_DrawTranslatedColumn (void) 
 { 
     int			count; 
     byte*		dest; 
+    byte*		source;
+    byte*		map;
     fixed_t		frac;
     fixed_t		fracstep;	 
+    int			pitch;
  
-    count = dc_yh - dc_yl; 
-    if (count < 0) 
+    count = dc_yh - dc_yl + 1; 
+    if (count <= 0) 
 	return; 
 				 
 #ifdef RANGECHECK 
@@ -445,24 +533,41 @@ void R_DrawTranslatedColumn (void)
 
 
     dest = ylookup[dc_yl] + columnofs[dc_x]; 
+    pitch = SCREENYSTEP;
+    source = dc_source;
+
+    // Translation tables are used
+    //  to map certain colorramps to other ones,
+    //  used with PLAY sprites.
+    // Thus the "green" ramp of the player 0 sprite
+    //  is mapped to gray, red, black/indigo. 
+    map = R_TranslatedMap ();
 
     // Looks familiar.
     fracstep = dc_iscale; 
     frac = dc_texturemid + (dc_yl-centery)*fracstep; 
 
-    // Here we do an additional index re-mapping.
-    do 
+    while (count >= 4)
     {
-	// Translation tables are used
-	//  to map certain colorramps to other ones,
-	//  used with PLAY sprites.
-	// Thus the "green" ramp of the player 0 sprite
-	//  is mapped to gray, red, black/indigo. 
-	*dest = dc_colormap[dc_translation[dc_source[frac>>FRACBITS]]];
-	dest += SCREENWIDTH;
-	
+	dest[0] = map[source[frac>>FRACBITS]];
+	frac += fracstep;
+	dest[pitch] = map[source[frac>>FRACBITS]];
+	frac += fracstep;
+	dest[pitch*2] = map[source[frac>>FRACBITS]];
+	frac += fracstep;
+	dest[pitch*3] = map[source[frac>>FRACBITS]];
+	frac += fracstep;
+
+	dest += pitch*4;
+	count -= 4;
+    }
+
+    while (count--)
+    {
+	*dest = map[source[frac>>FRACBITS]];
+	dest += pitch;
 	frac += fracstep; 
-    } while (count--); 
+    }
 } 
 
 void R_DrawTranslatedColumnLow (void) 
@@ -470,12 +575,15 @@ void R_DrawTranslatedColumnLow (void)
     int			count; 
     byte*		dest; 
     byte*		dest2; 
+    byte*		source;
+    byte*		map;
     fixed_t		frac;
     fixed_t		fracstep;	 
+    int			pitch;
     int                 x;
  
-    count = dc_yh - dc_yl; 
-    if (count < 0) 
+    count = dc_yh - dc_yl + 1; 
+    if (count <= 0) 
 	return; 
 
     // low detail, need to scale by 2
@@ -495,26 +603,121 @@ void R_DrawTranslatedColumnLow (void)
 
     dest = ylookup[dc_yl] + columnofs[x]; 
     dest2 = ylookup[dc_yl] + columnofs[x+1]; 
+    pitch = SCREENYSTEP;
+    source = dc_source;
+    map = R_TranslatedMap ();
 
     // Looks familiar.
     fracstep = dc_iscale; 
     frac = dc_texturemid + (dc_yl-centery)*fracstep; 
 
-    // Here we do an additional index re-mapping.
-    do 
+    while (count >= 2)
     {
-	// Translation tables are used
-	//  to map certain colorramps to other ones,
-	//  used with PLAY sprites.
-	// Thus the "green" ramp of the player 0 sprite
-	//  is mapped to gray, red, black/indigo. 
-	*dest = dc_colormap[dc_translation[dc_source[frac>>FRACBITS]]];
-	*dest2 = dc_colormap[dc_translation[dc_source[frac>>FRACBITS]]];
-	dest += SCREENWIDTH;
-	dest2 += SCREENWIDTH;
-	
-	frac += fracstep; 
-    } while (count--); 
+	dest[0] = dest2[0] = map[source[frac>>FRACBITS]];
+	frac += fracstep;
+	dest[pitch] = dest2[pitch] = map[source[frac>>FRACBITS]];
+	frac += fracstep;
+
+	dest += pitch*2;
+	dest2 += pitch*2;
+	count -= 2;
+    }
+
+    if (count)
+	*dest = *dest2 = map[source[frac>>FRACBITS]];
+} 
+
+
+
+
+//
+// R_DrawSkyColumn
+// The sky has no stepping through the texture; each row of
+//  the view takes the texture row R_SetSkyScale found for it.
+//
+void R_DrawSkyColumn (void) 
+{ 
+    int			count; 
+    byte*		dest; 
+    byte*		source;
+    byte*		rows;
+    lighttable_t*	colormap;
+    int			pitch;
+ 
+    count = dc_yh - dc_yl + 1; 
+    if (count <= 0) 
+	return; 
+				 
+#ifdef RANGECHECK 
+    if ((unsigned)dc_x >= SCREENWIDTH
+	|| dc_yl < 0
+	|| dc_yh >= SCREENHEIGHT) 
+	I_Error ("R_DrawSkyColumn: %i to %i at %i", dc_yl, dc_yh, dc_x); 
+#endif 
+
+    dest = ylookup[dc_yl] + columnofs[dc_x];  
+    pitch = SCREENYSTEP;
+    source = dc_source;
+    colormap = dc_colormap;
+    rows = skyrows + dc_yl;
+
+    while (count >= 4)
+    {
+	dest[0] = colormap[source[rows[0]]];
+	dest[pitch] = colormap[source[rows[1]]];
+	dest[pitch*2] = colormap[source[rows[2]]];
+	dest[pitch*3] = colormap[source[rows[3]]];
+
+	dest += pitch*4;
+	rows += 4;
+	count -= 4;
+    }
+
+    while (count--)
+    {
+	*dest = colormap[source[*rows++]];
+	dest += pitch;
+    }
+} 
+
+void R_DrawSkyColumnLow (void) 
+{ 
+    int			count; 
+    byte*		dest; 
+    byte*		dest2;
+    byte*		source;
+    byte*		rows;
+    lighttable_t*	colormap;
+    int			pitch;
+    int                 x;
+ 
+    count = dc_yh - dc_yl + 1; 
+    if (count <= 0) 
+	return; 
+
+    // Blocky mode, need to multiply by 2.
+    x = dc_x << 1;
+				 
+#ifdef RANGECHECK 
+    if ((unsigned)x >= SCREENWIDTH
+	|| dc_yl < 0
+	|| dc_yh >= SCREENHEIGHT) 
+	I_Error ("R_DrawSkyColumn: %i to %i at %i", dc_yl, dc_yh, dc_x); 
+#endif 
+
+    dest = ylookup[dc_yl] + columnofs[x];
+    dest2 = ylookup[dc_yl] + columnofs[x+1];
+    pitch = SCREENYSTEP;
+    source = dc_source;
+    colormap = dc_colormap;
+    rows = skyrows + dc_yl;
+
+    while (count--)
+    {
+	*dest2 = *dest = colormap[source[*rows++]];
+	dest += pitch;
+	dest2 += pitch;
+    }
 } 
 
 
@@ -567,19 +770,19 @@ void R_InitTranslationTables (void)
 // In consequence, flats are not stored by column (like walls),
 //  and the inner loop has to step in texture space u and v.
 //
-int			ds_y; 
-int			ds_x1; 
-int			ds_x2;
+R_THREADLOCAL int		ds_y; 
+R_THREADLOCAL int		ds_x1; 
+R_THREADLOCAL int		ds_x2;
 
-lighttable_t*		ds_colormap; 
+R_THREADLOCAL lighttable_t*	ds_colormap; 
 
-fixed_t			ds_xfrac; 
-fixed_t			ds_yfrac; 
-fixed_t			ds_xstep; 
-fixed_t			ds_ystep;
+R_THREADLOCAL fixed_t		ds_xfrac; 
+R_THREADLOCAL fixed_t		ds_yfrac; 
+R_THREADLOCAL fixed_t		ds_xstep; 
+R_THREADLOCAL fixed_t		ds_ystep;
 
 // start of a 64*64 tile image 
-byte*			ds_source;	
+R_THREADLOCAL byte*		ds_source;	
 
 // just for profiling
 int			dscount;
@@ -631,7 +834,8 @@ void R_DrawSpan (void)
 
 	// Lookup pixel from flat texture tile,
 	//  re-index using light/colormap.
-	*dest++ = ds_colormap[ds_source[spot]];
+	*dest = ds_colormap[ds_source[spot]];
+	dest += SCREENXSTEP;
 
         position += step;
 
@@ -758,8 +962,9 @@ void R_DrawSpanLow (void)
 
 	// Lowres/blocky mode does it twice,
 	//  while scale is adjusted appropriately.
-	*dest++ = ds_colormap[ds_source[spot]];
-	*dest++ = ds_colormap[ds_source[spot]];
+	dest[0] = ds_colormap[ds_source[spot]];
+	dest[SCREENXSTEP] = ds_colormap[ds_source[spot]];
+	dest += 2 * SCREENXSTEP;
 
 	position += step;
 
@@ -780,6 +985,17 @@ R_InitBuffer
 { 
     int		i; 
 
+    // Sized once, for the full screen.
+    if (ylookup == NULL)
+    {
+	ylookup = Z_Malloc (SCREENHEIGHT * sizeof(*ylookup), PU_STATIC, NULL);
+	columnofs = Z_Malloc (SCREENWIDTH * sizeof(*columnofs),
+			      PU_STATIC, NULL);
+
+	for (i=0 ; i<FUZZTABLE ; i++)
+	    fuzzoffset[i] *= SCREENYSTEP;
+    }
+
     // Handle resize,
     //  e.g. smaller view windows
     //  with border and/or status bar.
@@ -787,7 +1003,7 @@ R_InitBuffer
 
     // Column offset. For windows.
     for (i=0 ; i<width ; i++) 
-	columnofs[i] = viewwindowx + i;
+	columnofs[i] = SCREENOFS(viewwindowx + i, 0);
 
     // Samw with base row offset.
     if (width == SCREENWIDTH) 
@@ -797,7 +1013,7 @@ R_InitBuffer
 
     // Preclaculate all row offsets.
     for (i=0 ; i<height ; i++) 
-	ylookup[i] = I_VideoBuffer + (i+viewwindowy)*SCREENWIDTH; 
+	ylookup[i] = I_VideoBuffer + SCREENOFS(0, i+viewwindowy); 
 } 
  
  
@@ -815,6 +1031,10 @@ void R_FillBackScreen (void)
     byte*	dest; 
     int		x;
     int		y; 
+    int		windowx;
+    int		windowy;
+    int		width;
+    int		height;
     patch_t*	patch;
 
     // DOOM border patch.
@@ -843,7 +1063,9 @@ void R_FillBackScreen (void)
 	
     if (background_buffer == NULL)
     {
-        background_buffer = Z_Malloc(SCREENWIDTH * (SCREENHEIGHT - SBARHEIGHT),
+        // Addressed like the framebuffer, so it covers the status bar
+        // rows too even though only the view area is used.
+        background_buffer = Z_Malloc(SCREENWIDTH * SCREENHEIGHT,
                                      PU_STATIC, NULL);
     }
 
@@ -853,59 +1075,61 @@ void R_FillBackScreen (void)
 	name = name1;
     
     src = W_CacheLumpName(name, PU_CACHE); 
-    dest = background_buffer;
-	 
+
+    // Each flat pixel covers 1 << hires screen pixels each way.
     for (y=0 ; y<SCREENHEIGHT-SBARHEIGHT ; y++) 
     { 
-	for (x=0 ; x<SCREENWIDTH/64 ; x++) 
-	{ 
-	    memcpy (dest, src+((y&63)<<6), 64); 
-	    dest += 64; 
-	} 
+	dest = background_buffer + SCREENOFS(0, y);
 
-	if (SCREENWIDTH&63) 
+	for (x=0 ; x<SCREENWIDTH ; x++) 
 	{ 
-	    memcpy (dest, src+((y&63)<<6), SCREENWIDTH&63); 
-	    dest += (SCREENWIDTH&63); 
+	    *dest = src[(((y >> hires) & 63) << 6) + ((x >> hires) & 63)];
+	    dest += SCREENXSTEP;
 	} 
     } 
      
     // Draw screen and bezel; this is done to a separate screen buffer.
+    // The patches are placed in original 320x200 coordinates.
 
     V_UseBuffer(background_buffer);
 
+    windowx = viewwindowx >> hires;
+    windowy = viewwindowy >> hires;
+    width = scaledviewwidth >> hires;
+    height = viewheight >> hires;
+
     patch = W_CacheLumpName(DEH_String("brdr_t"),PU_CACHE);
 
-    for (x=0 ; x<scaledviewwidth ; x+=8)
-	V_DrawPatch(viewwindowx+x, viewwindowy-8, patch);
+    for (x=0 ; x<width ; x+=8)
+	V_DrawPatch(windowx+x, windowy-8, patch);
     patch = W_CacheLumpName(DEH_String("brdr_b"),PU_CACHE);
 
-    for (x=0 ; x<scaledviewwidth ; x+=8)
-	V_DrawPatch(viewwindowx+x, viewwindowy+viewheight, patch);
+    for (x=0 ; x<width ; x+=8)
+	V_DrawPatch(windowx+x, windowy+height, patch);
     patch = W_CacheLumpName(DEH_String("brdr_l"),PU_CACHE);
 
-    for (y=0 ; y<viewheight ; y+=8)
-	V_DrawPatch(viewwindowx-8, viewwindowy+y, patch);
+    for (y=0 ; y<height ; y+=8)
+	V_DrawPatch(windowx-8, windowy+y, patch);
     patch = W_CacheLumpName(DEH_String("brdr_r"),PU_CACHE);
 
-    for (y=0 ; y<viewheight ; y+=8)
-	V_DrawPatch(viewwindowx+scaledviewwidth, viewwindowy+y, patch);
+    for (y=0 ; y<height ; y+=8)
+	V_DrawPatch(windowx+width, windowy+y, patch);
 
     // Draw beveled edge. 
-    V_DrawPatch(viewwindowx-8,
-                viewwindowy-8,
+    V_DrawPatch(windowx-8,
+                windowy-8,
                 W_CacheLumpName(DEH_String("brdr_tl"),PU_CACHE));
     
-    V_DrawPatch(viewwindowx+scaledviewwidth,
-                viewwindowy-8,
+    V_DrawPatch(windowx+width,
+                windowy-8,
                 W_CacheLumpName(DEH_String("brdr_tr"),PU_CACHE));
     
-    V_DrawPatch(viewwindowx-8,
-                viewwindowy+viewheight,
+    V_DrawPatch(windowx-8,
+                windowy+height,
                 W_CacheLumpName(DEH_String("brdr_bl"),PU_CACHE));
     
-    V_DrawPatch(viewwindowx+scaledviewwidth,
-                viewwindowy+viewheight,
+    V_DrawPatch(windowx+width,
+                windowy+height,
                 W_CacheLumpName(DEH_String("brdr_br"),PU_CACHE));
 
     V_RestoreBuffer();
@@ -933,6 +1157,33 @@ R_VideoErase
 } 
 
 
+//
+// R_VideoEraseRect
+// Copies a rectangle of the back screen,
+//  one contiguous run at a time.
+//
+void
+R_VideoEraseRect
+( int		x,
+  int		y,
+  int		width,
+  int		height )
+{
+    int		i;
+
+    if (width <= 0 || height <= 0)
+	return;
+
+#ifdef COLUMN_MAJOR_VIDEO
+    for (i=0 ; i<width ; i++)
+	R_VideoErase (SCREENOFS(x+i, y), height);
+#else
+    for (i=0 ; i<height ; i++)
+	R_VideoErase (SCREENOFS(x, y+i), width);
+#endif
+}
+
+
 //
 // R_DrawViewBorder
 // Draws the border around the view
@@ -942,8 +1193,6 @@ void R_DrawViewBorder (void)
 { 
     int		top;
     int		side;
-    int		ofs;
-    int		i; 
  
     if (scaledviewwidth == SCREENWIDTH) 
 	return; 
@@ -951,22 +1200,13 @@ void R_DrawViewBorder (void)
     top = ((SCREENHEIGHT-SBARHEIGHT)-viewheight)/2; 
     side = (SCREENWIDTH-scaledviewwidth)/2; 
  
-    // copy top and one line of left side 
-    R_VideoErase (0, top*SCREENWIDTH+side); 
- 
-    // copy one line of right side and bottom 
-    ofs = (viewheight+top)*SCREENWIDTH-side; 
-    R_VideoErase (ofs, top*SCREENWIDTH+side); 
+    // copy top and bottom
+    R_VideoEraseRect (0, 0, SCREENWIDTH, top);
+    R_VideoEraseRect (0, top+viewheight, SCREENWIDTH, top);
  
-    // copy sides using wraparound 
-    ofs = top*SCREENWIDTH + SCREENWIDTH-side; 
-    side <<= 1;
-    
-    for (i=1 ; i<viewheight ; i++) 
-    { 
-	R_VideoErase (ofs, side); 
-	ofs += SCREENWIDTH; 
-    } 
+    // copy sides
+    R_VideoEraseRect (0, top, side, viewheight);
+    R_VideoEraseRect (SCREENWIDTH-side, top, side, viewheight);
 
     // ? 
     V_MarkRect (0,0,SCREENWIDTH, SCREENHEIGHT-SBARHEIGHT); 
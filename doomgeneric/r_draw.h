@@ -23,15 +23,23 @@
 
 
 
-extern lighttable_t*	dc_colormap;
-extern int		dc_x;
-extern int		dc_yl;
-extern int		dc_yh;
-extern fixed_t		dc_iscale;
-extern fixed_t		dc_texturemid;
+// The drawer state below is per thread when the player view
+// can be drawn in strips on several threads (see r_thread.c).
+#ifdef HAVE_PTHREAD
+#define R_THREADLOCAL	__thread
+#else
+#define R_THREADLOCAL
+#endif
+
+extern R_THREADLOCAL lighttable_t*	dc_colormap;
+extern R_THREADLOCAL int		dc_x;
+extern R_THREADLOCAL int		dc_yl;
+extern R_THREADLOCAL int		dc_yh;
+extern R_THREADLOCAL fixed_t		dc_iscale;
+extern R_THREADLOCAL fixed_t		dc_texturemid;
 
 // first pixel in a column
-extern byte*		dc_source;		
+extern R_THREADLOCAL byte*		dc_source;		
 
 
 // The span blitting interface.
@@ -44,33 +52,49 @@ void 	R_DrawColumnLow (void);
 void 	R_DrawFuzzColumn (void);
 void 	R_DrawFuzzColumnLow (void);
 
+// Position in the fuzz table, carried over from column to column.
+extern R_THREADLOCAL int		fuzzpos;
+
+void	R_SkipFuzzColumn (void);
+
 // Draw with color translation tables,
 //  for player sprite rendering,
 //  Green/Red/Blue/Indigo shirts.
 void	R_DrawTranslatedColumn (void);
 void	R_DrawTranslatedColumnLow (void);
 
+// The sky, at the fixed scale set by R_SetSkyScale.
+void	R_DrawSkyColumn (void);
+void	R_DrawSkyColumnLow (void);
+
 void
 R_VideoErase
 ( unsigned	ofs,
   int		count );
 
-extern int		ds_y;
-extern int		ds_x1;
-extern int		ds_x2;
+void
+R_VideoEraseRect
+( int		x,
+  int		y,
+  int		width,
+  int		height );
+
+extern R_THREADLOCAL int		ds_y;
+extern R_THREADLOCAL int		ds_x1;
+extern R_THREADLOCAL int		ds_x2;
 
-extern lighttable_t*	ds_colormap;
+extern R_THREADLOCAL lighttable_t*	ds_colormap;
 
-extern fixed_t		ds_xfrac;
-extern fixed_t		ds_yfrac;
-extern fixed_t		ds_xstep;
-extern fixed_t		ds_ystep;
+extern R_THREADLOCAL fixed_t		ds_xfrac;
+extern R_THREADLOCAL fixed_t		ds_yfrac;
+extern R_THREADLOCAL fixed_t		ds_xstep;
+extern R_THREADLOCAL fixed_t		ds_ystep;
 
 // start of a 64*64 tile image
-extern byte*		ds_source;		
+extern R_THREADLOCAL byte*		ds_source;		
 
 extern byte*		translationtables;
-extern byte*		dc_translation;
+extern R_THREADLOCAL byte*		dc_translation;
 
 
 // Span blitting for rows, floor/ceiling.
@@ -28,9 +28,14 @@
 
 #include "doomdef.h"
 #include "d_loop.h"
+#include "d_main.h"
+#include "doomstat.h"
 
+#include "m_argv.h"
 #include "m_bbox.h"
 #include "m_menu.h"
+#include "p_tick.h"
+#include "z_zone.h"
 
 #include "r_local.h"
 #include "r_sky.h"
@@ -46,6 +51,16 @@
 
 int			viewangleoffset;
 
+fixed_t			fractionaltic = FRACUNIT;
+
+boolean			localview;
+angle_t			localviewturn;
+
+// Positions moved for drawing in between tics, to put back.
+static fixed_t*		interpsaved;
+static int		interpsavedsize;
+static angle_t		interpviewangle;
+
 // increment every time a check is made
 int			validcount = 1;		
 
@@ -95,7 +110,7 @@ int			viewangletox[FINEANGLES/2];
 // The xtoviewangleangle[] table maps a screen pixel
 // to the lowest viewangle that maps back to x ranges
 // from clipangle to -clipangle.
-angle_t			xtoviewangle[SCREENWIDTH+1];
+angle_t*		xtoviewangle;
 
 lighttable_t*		scalelight[LIGHTLEVELS][MAXLIGHTSCALE];
 lighttable_t*		scalelightfixed[MAXLIGHTSCALE];
@@ -110,8 +125,29 @@ void (*colfunc) (void);
 void (*basecolfunc) (void);
 void (*fuzzcolfunc) (void);
 void (*transcolfunc) (void);
+void (*skycolfunc) (void);
 void (*spanfunc) (void);
 
+// If non-zero, drawsegs, openings and solidsegs are held
+// to their vanilla sizes instead of growing on demand.
+int			vanilla_render_limit = 0;
+
+// Frame time budget in milliseconds. When non-zero, the detail
+// governor lowers detail and view size to stay within it.
+int			render_frame_budget = 0;
+
+// Frames between governor steps. Restoring detail waits longer
+// than dropping it so that a borderline load does not flicker.
+#define GOVERNOR_DOWNHOLD	(TICRATE/2)
+#define GOVERNOR_UPHOLD		(TICRATE*3)
+
+// Smallest view the governor shrinks to, in screenblocks.
+#define GOVERNOR_MINBLOCKS	7
+
+static int		governor_level;		// 0 = the player's settings
+static int		governor_avg;		// smoothed frame time, ms << 4
+static int		governor_hold;
+
 
 
 //
@@ -155,21 +191,21 @@ R_PointOnSide
 	
     if (!node->dx)
     {
-	if (x <= node->x)
+	if (x <= node->x<<FRACBITS)
 	    return node->dy > 0;
 	
 	return node->dy < 0;
     }
     if (!node->dy)
     {
-	if (y <= node->y)
+	if (y <= node->y<<FRACBITS)
 	    return node->dx < 0;
 	
 	return node->dx > 0;
     }
 	
-    dx = (x - node->x);
-    dy = (y - node->y);
+    dx = (x - (node->x<<FRACBITS));
+    dy = (y - (node->y<<FRACBITS));
 	
     // Try to quickly decide by looking at sign bits.
     if ( (node->dy ^ node->dx ^ dx ^ dy)&0x80000000 )
@@ -182,8 +218,8 @@ R_PointOnSide
 	return 0;
     }
 
-    left = FixedMul ( node->dy>>FRACBITS , dx );
-    right = FixedMul ( dy , node->dx>>FRACBITS );
+    left = FixedMul ( node->dy , dx );
+    right = FixedMul ( dy , node->dx );
 	
     if (right < left)
     {
@@ -622,7 +658,7 @@ void R_InitLightTables (void)
 	startmap = ((LIGHTLEVELS-1-i)*2)*NUMCOLORMAPS/LIGHTLEVELS;
 	for (j=0 ; j<MAXLIGHTZ ; j++)
 	{
-	    scale = FixedDiv ((SCREENWIDTH/2*FRACUNIT), (j+1)<<LIGHTZSHIFT);
+	    scale = FixedDiv ((ORIGWIDTH/2*FRACUNIT), (j+1)<<LIGHTZSHIFT);
 	    scale >>= LIGHTSCALESHIFT;
 	    level = startmap - scale/DISTMAP;
 	    
@@ -682,8 +718,8 @@ void R_ExecuteSetViewSize (void)
     }
     else
     {
-	scaledviewwidth = setblocks*32;
-	viewheight = (setblocks*168/10)&~7;
+	scaledviewwidth = (setblocks*32)<<hires;
+	viewheight = ((setblocks*168/10)&~7)<<hires;
     }
     
     detailshift = setdetail;
@@ -700,6 +736,7 @@ void R_ExecuteSetViewSize (void)
 	colfunc = basecolfunc = R_DrawColumn;
 	fuzzcolfunc = R_DrawFuzzColumn;
 	transcolfunc = R_DrawTranslatedColumn;
+	skycolfunc = R_DrawSkyColumn;
 	spanfunc = R_DrawSpan;
     }
     else
@@ -707,6 +744,7 @@ void R_ExecuteSetViewSize (void)
 	colfunc = basecolfunc = R_DrawColumnLow;
 	fuzzcolfunc = R_DrawFuzzColumnLow;
 	transcolfunc = R_DrawTranslatedColumnLow;
+	skycolfunc = R_DrawSkyColumnLow;
 	spanfunc = R_DrawSpanLow;
     }
 
@@ -715,8 +753,11 @@ void R_ExecuteSetViewSize (void)
     R_InitTextureMapping ();
     
     // psprite scales
-    pspritescale = FRACUNIT*viewwidth/SCREENWIDTH;
-    pspriteiscale = FRACUNIT*SCREENWIDTH/viewwidth;
+    pspritescale = FRACUNIT*viewwidth/ORIGWIDTH;
+    pspriteiscale = FRACUNIT*ORIGWIDTH/viewwidth;
+
+    // sky scale
+    R_SetSkyScale (pspriteiscale>>detailshift);
     
     // thing clipping
     for (i=0 ; i<viewwidth ; i++)
@@ -766,8 +807,51 @@ void R_ExecuteSetViewSize (void)
 
 void R_Init (void)
 {
+    int		p;
+
+    //!
+    // @category compat
+    //
+    // Hold drawsegs, openings and solidsegs to their Vanilla sizes
+    // instead of growing them as needed.
+    //
+
+    if (M_CheckParm ("-vanillalimits"))
+	vanilla_render_limit = 1;
+
+    //!
+    // @arg <ms>
+    // @category video
+    //
+    // Keep rendered frames under ms milliseconds by dropping to low
+    // detail and then shrinking the view, restoring them once the
+    // load drops. 0 disables this.
+    //
+
+    p = M_CheckParmWithArgs ("-framebudget", 1);
+
+    if (p > 0)
+	render_frame_budget = atoi (myargv[p+1]);
+
+    //!
+    // @arg <n>
+    // @category video
+    //
+    // Draw the player view on n threads, each drawing a vertical
+    // strip of the screen. 1 draws it all on the main thread.
+    //
+
+    p = M_CheckParmWithArgs ("-renderthreads", 1);
+
+    if (p > 0)
+	render_threads = atoi (myargv[p+1]);
+
+    xtoviewangle = Z_Malloc ((SCREENWIDTH+1) * sizeof(*xtoviewangle),
+			     PU_STATIC, NULL);
+
     R_InitData ();
     printf (".");
+    D_StartupPhase ("R_InitTables");
     R_InitPointToAngle ();
     printf (".");
     R_InitTables ();
@@ -777,16 +861,131 @@ void R_Init (void)
     R_SetViewSize (screenblocks, detailLevel);
     R_InitPlanes ();
     printf (".");
+    D_StartupPhase ("R_InitLightTables");
     R_InitLightTables ();
     printf (".");
     R_InitSkyMap ();
     R_InitTranslationTables ();
     printf (".");
+    R_InitThreads ();
 	
     framecount = 0;
 }
 
 
+//
+// R_ClearLevelPeaks
+// Called at level setup. Resets the high water marks of
+// the growable render arrays, reporting the last level's
+// usage first when running with -devparm.
+//
+void R_ClearLevelPeaks (void)
+{
+    if (devparm && peakdrawsegs > 0)
+    {
+	printf ("R_ClearLevelPeaks: drawsegs %i/%i, openings %i/%i, "
+		"solidsegs %i/%i\n",
+		peakdrawsegs, maxdrawsegs,
+		peakopenings, maxopenings,
+		peaksolidsegs, maxsolidsegs);
+    }
+
+    peakdrawsegs = 0;
+    peakopenings = 0;
+    peaksolidsegs = 0;
+}
+
+
+//
+// R_GovernorSettings
+// View size and detail for the given governor level:
+//  low detail first, then one screenblock per level.
+//
+static void R_GovernorSettings (int level, int* blocks, int* detail)
+{
+    *blocks = screenblocks;
+    *detail = detailLevel;
+
+    if (level > 0 && !*detail)
+    {
+	*detail = 1;
+	level--;
+    }
+
+    // The full screen view (11) steps straight down to 10.
+    if (level > 0 && *blocks > 10)
+    {
+	*blocks = 10;
+	level--;
+    }
+
+    if (*blocks - level >= GOVERNOR_MINBLOCKS)
+	*blocks -= level;
+    else if (*blocks > GOVERNOR_MINBLOCKS)
+	*blocks = GOVERNOR_MINBLOCKS;
+}
+
+
+//
+// R_UpdateGovernor
+// Called by D_Display with the time taken by a frame that
+// rendered the player view. Only the view size and detail
+// are touched; the menu settings and game state are not.
+//
+void R_UpdateGovernor (int frametime)
+{
+    int		blocks;
+    int		detail;
+    int		nextblocks;
+    int		nextdetail;
+
+    if (render_frame_budget <= 0)
+	return;
+
+    // Average over roughly eight frames.
+    governor_avg += ((frametime << 4) - governor_avg) / 8;
+
+    if (governor_hold > 0)
+    {
+	governor_hold--;
+	return;
+    }
+
+    R_GovernorSettings (governor_level, &blocks, &detail);
+
+    if (governor_avg > render_frame_budget << 4)
+    {
+	R_GovernorSettings (governor_level + 1, &nextblocks, &nextdetail);
+
+	if (nextblocks == blocks && nextdetail == detail)
+	    return;
+
+	governor_level++;
+	governor_hold = GOVERNOR_DOWNHOLD;
+    }
+    else if (governor_level > 0
+	     && governor_avg < (render_frame_budget << 4) * 3 / 4)
+    {
+	governor_level--;
+	governor_hold = GOVERNOR_UPHOLD;
+    }
+    else
+    {
+	// Follow menu changes to the view size or detail.
+	if (blocks == setblocks && detail == setdetail)
+	    return;
+    }
+
+    R_GovernorSettings (governor_level, &blocks, &detail);
+
+    if (devparm)
+	printf ("R_UpdateGovernor: %i ms, level %i (blocks %i, detail %i)\n",
+		governor_avg >> 4, governor_level, blocks, detail);
+
+    R_SetViewSize (blocks, detail);
+}
+
+
 //
 // R_PointInSubsector
 //
@@ -817,6 +1016,113 @@ R_PointInSubsector
 
 
 
+//
+// R_InterpolateLevel
+// Moves the mobjs, the view and the sector planes fractionaltic
+// of the way from where they were before the last tic to where
+// they are now, keeping where they are in interpsaved.  Only what
+// the player view is drawn from is moved; R_RestoreLevel puts it
+// all back before the game can see it.
+//
+#define LERP(old, cur)	((old) + FixedMul ((cur) - (old), fractionaltic))
+
+static void R_InterpolateLevel (player_t* player)
+{
+    sector_t*	sector;
+    mobj_t*	mo;
+    fixed_t*	saved;
+    fixed_t*	newsaved;
+    int		count;
+    int		i;
+
+    count = 0;
+
+    for (i=0, sector=sectors ; i<numsectors ; i++, sector++)
+    {
+	count += 2;
+
+	for (mo = sector->thinglist ; mo ; mo = mo->snext)
+	    count += 3;
+    }
+
+    if (count + 1 > interpsavedsize)
+    {
+	newsaved = Z_Malloc ((count + 1) * 2 * sizeof(*newsaved),
+			     PU_STATIC, NULL);
+
+	if (interpsaved)
+	    Z_Free (interpsaved);
+
+	interpsaved = newsaved;
+	interpsavedsize = (count + 1) * 2;
+    }
+
+    saved = interpsaved;
+
+    for (i=0, sector=sectors ; i<numsectors ; i++, sector++)
+    {
+	*saved++ = sector->floorheight;
+	*saved++ = sector->ceilingheight;
+	sector->floorheight = LERP(sector->oldfloorheight,
+				   sector->floorheight);
+	sector->ceilingheight = LERP(sector->oldceilingheight,
+				     sector->ceilingheight);
+
+	for (mo = sector->thinglist ; mo ; mo = mo->snext)
+	{
+	    *saved++ = mo->x;
+	    *saved++ = mo->y;
+	    *saved++ = mo->z;
+	    mo->x = LERP(mo->oldx, mo->x);
+	    mo->y = LERP(mo->oldy, mo->y);
+	    mo->z = LERP(mo->oldz, mo->z);
+	}
+    }
+
+    *saved = player->viewz;
+    player->viewz = LERP(player->oldviewz, player->viewz);
+
+    interpviewangle = player->mo->angle;
+
+    if (localview)
+	player->mo->angle += localviewturn;
+    else
+	player->mo->angle = player->mo->oldangle
+	    + FixedMul (player->mo->angle - player->mo->oldangle,
+			fractionaltic);
+}
+
+
+//
+// R_RestoreLevel
+//
+static void R_RestoreLevel (player_t* player)
+{
+    sector_t*	sector;
+    mobj_t*	mo;
+    fixed_t*	saved;
+    int		i;
+
+    saved = interpsaved;
+
+    for (i=0, sector=sectors ; i<numsectors ; i++, sector++)
+    {
+	sector->floorheight = *saved++;
+	sector->ceilingheight = *saved++;
+
+	for (mo = sector->thinglist ; mo ; mo = mo->snext)
+	{
+	    mo->x = *saved++;
+	    mo->y = *saved++;
+	    mo->z = *saved++;
+	}
+    }
+
+    player->viewz = *saved;
+    player->mo->angle = interpviewangle;
+}
+
+
 //
 // R_SetupFrame
 //
@@ -862,7 +1168,18 @@ void R_SetupFrame (player_t* player)
 //
 void R_RenderPlayerView (player_t* player)
 {	
+    boolean	interpolate;
+
+    // Draw in between tics only if the last one kept where
+    // everything was before it.
+    interpolate = fractionaltic < FRACUNIT
+	       && oldpositionstic == gametic - 1;
+
+    if (interpolate)
+	R_InterpolateLevel (player);
+
     R_SetupFrame (player);
+    R_BeginStrips ();
 
     // Clear buffers.
     R_ClearClipSegs ();
@@ -886,6 +1203,12 @@ void R_RenderPlayerView (player_t* player)
     
     R_DrawMasked ();
 
+    // Draw what was recorded when drawing on several threads.
+    R_DrawStrips ();
+
+    if (interpolate)
+	R_RestoreLevel (player);
+
     // Check for new console commands.
     NetUpdate ();				
 }
@@ -35,6 +35,16 @@ extern fixed_t		viewsin;
 extern int		viewwindowx;
 extern int		viewwindowy;
 
+// How far the frame is drawn from the tic before the last one
+// to the last one.  FRACUNIT draws the last tic as it is.
+extern fixed_t		fractionaltic;
+
+// If true, the view of the console player is that of the last
+// tic turned on by localviewturn, rather than turning from the
+// tic before.
+extern boolean		localview;
+extern angle_t		localviewturn;
+
 
 
 extern int		centerx;
@@ -73,6 +83,9 @@ extern lighttable_t*	zlight[LIGHTLEVELS][MAXLIGHTZ];
 extern int		extralight;
 extern lighttable_t*	fixedcolormap;
 
+extern int		vanilla_render_limit;
+extern int		render_frame_budget;
+
 
 // Number of diminishing brightness levels.
 // There a 0-31, i.e. 32 LUT in the COLORMAP lump.
@@ -93,6 +106,7 @@ extern void		(*colfunc) (void);
 extern void		(*transcolfunc) (void);
 extern void		(*basecolfunc) (void);
 extern void		(*fuzzcolfunc) (void);
+extern void		(*skycolfunc) (void);
 // No shadow effects on floors.
 extern void		(*spanfunc) (void);
 
@@ -157,4 +171,10 @@ void R_Init (void);
 // Called by M_Responder.
 void R_SetViewSize (int blocks, int detail);
 
+// Called by P_SetupLevel.
+void R_ClearLevelPeaks (void);
+
+// Called by D_Display.
+void R_UpdateGovernor (int frametime);
+
 #endif
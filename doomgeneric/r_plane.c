@@ -50,24 +50,28 @@ visplane_t*		ceilingplane;
 
 // ?
 #define MAXOPENINGS	SCREENWIDTH*64
-short			openings[MAXOPENINGS];
+short*			openings;
+int			maxopenings;
 short*			lastopening;
 
+// High water mark for the current level.
+int			peakopenings;
+
 
 //
 // Clip values are the solid pixel bounding the range.
 //  floorclip starts out SCREENHEIGHT
 //  ceilingclip starts out -1
 //
-short			floorclip[SCREENWIDTH];
-short			ceilingclip[SCREENWIDTH];
+short*			floorclip;
+short*			ceilingclip;
 
 //
 // spanstart holds the start of a plane span
 // initialized to 0 at start
 //
-int			spanstart[SCREENHEIGHT];
-int			spanstop[SCREENHEIGHT];
+int*			spanstart;
+int*			spanstop;
 
 //
 // texture mapping
@@ -75,15 +79,18 @@ int			spanstop[SCREENHEIGHT];
 lighttable_t**		planezlight;
 fixed_t			planeheight;
 
-fixed_t			yslope[SCREENHEIGHT];
-fixed_t			distscale[SCREENWIDTH];
+fixed_t*		yslope;
+fixed_t*		distscale;
 fixed_t			basexscale;
 fixed_t			baseyscale;
 
-fixed_t			cachedheight[SCREENHEIGHT];
-fixed_t			cacheddistance[SCREENHEIGHT];
-fixed_t			cachedxstep[SCREENHEIGHT];
-fixed_t			cachedystep[SCREENHEIGHT];
+fixed_t*		cachedheight;
+fixed_t*		cacheddistance;
+fixed_t*		cachedxstep;
+fixed_t*		cachedystep;
+
+// sky texture column behind each column of the view
+static byte**		skycolumns;
 
 
 
@@ -93,7 +100,116 @@ fixed_t			cachedystep[SCREENHEIGHT];
 //
 void R_InitPlanes (void)
 {
-  // Doh!
+    unsigned short*	clips;
+    int			clipsize;
+    int			i;
+
+    floorclip = Z_Malloc (SCREENWIDTH * sizeof(*floorclip), PU_STATIC, NULL);
+    ceilingclip = Z_Malloc (SCREENWIDTH * sizeof(*ceilingclip), PU_STATIC, NULL);
+    distscale = Z_Malloc (SCREENWIDTH * sizeof(*distscale), PU_STATIC, NULL);
+    skycolumns = Z_Malloc (SCREENWIDTH * sizeof(*skycolumns), PU_STATIC, NULL);
+
+    spanstart = Z_Malloc (SCREENHEIGHT * sizeof(*spanstart), PU_STATIC, NULL);
+    spanstop = Z_Malloc (SCREENHEIGHT * sizeof(*spanstop), PU_STATIC, NULL);
+    yslope = Z_Malloc (SCREENHEIGHT * sizeof(*yslope), PU_STATIC, NULL);
+    cachedheight = Z_Malloc (SCREENHEIGHT * sizeof(*cachedheight),
+			     PU_STATIC, NULL);
+    cacheddistance = Z_Malloc (SCREENHEIGHT * sizeof(*cacheddistance),
+			       PU_STATIC, NULL);
+    cachedxstep = Z_Malloc (SCREENHEIGHT * sizeof(*cachedxstep),
+			    PU_STATIC, NULL);
+    cachedystep = Z_Malloc (SCREENHEIGHT * sizeof(*cachedystep),
+			    PU_STATIC, NULL);
+
+    // top and bottom of every visplane, each with a pad
+    //  entry on either side
+    clipsize = MAXVISPLANES * 2 * (SCREENWIDTH + 2) * sizeof(*clips);
+    clips = Z_Malloc (clipsize, PU_STATIC, NULL);
+    memset (clips, 0, clipsize);
+
+    for (i=0 ; i<MAXVISPLANES ; i++)
+    {
+	visplanes[i].top = clips + 1;
+	clips += SCREENWIDTH + 2;
+	visplanes[i].bottom = clips + 1;
+	clips += SCREENWIDTH + 2;
+    }
+
+    openings = Z_Malloc (MAXOPENINGS * sizeof(*openings), PU_STATIC, NULL);
+    maxopenings = MAXOPENINGS;
+    lastopening = openings;
+}
+
+
+//
+// R_RebaseClip
+// Moves a drawseg clip or masked column pointer from the
+//  old openings array into the new one. Pointers into
+//  screenheightarray and negonearray are left alone.
+//
+static short*
+R_RebaseClip
+( short*	clip,
+  int		x1,
+  short*	oldopenings,
+  int		used )
+{
+    if (clip == NULL
+     || clip + x1 < oldopenings
+     || clip + x1 >= oldopenings + used)
+    {
+	return clip;
+    }
+
+    return openings + (clip - oldopenings);
+}
+
+
+//
+// R_CheckOpenings
+// Makes room for needed more entries in openings,
+//  growing the array if necessary. The drawsegs stored
+//  so far this frame (including ds_p) point into it,
+//  so they are moved along with it.
+//
+void R_CheckOpenings (int needed)
+{
+    short*	oldopenings;
+    drawseg_t*	ds;
+    int		used;
+    int		newmax;
+
+    used = lastopening - openings;
+
+    if (used + needed <= maxopenings)
+	return;
+
+    if (vanilla_render_limit)
+	I_Error ("R_CheckOpenings: opening overflow (%i)", used + needed);
+
+    newmax = maxopenings * 2;
+
+    while (newmax < used + needed)
+	newmax *= 2;
+
+    oldopenings = openings;
+    openings = Z_Malloc (newmax * sizeof(*openings), PU_STATIC, NULL);
+    memcpy (openings, oldopenings, used * sizeof(*openings));
+
+    for (ds = drawsegs ; ds <= ds_p ; ds++)
+    {
+	ds->sprtopclip = R_RebaseClip (ds->sprtopclip, ds->x1,
+				       oldopenings, used);
+	ds->sprbottomclip = R_RebaseClip (ds->sprbottomclip, ds->x1,
+					  oldopenings, used);
+	ds->maskedtexturecol = R_RebaseClip (ds->maskedtexturecol, ds->x1,
+					     oldopenings, used);
+    }
+
+    Z_Free (oldopenings);
+
+    lastopening = openings + used;
+    maxopenings = newmax;
 }
 
 
@@ -191,7 +307,7 @@ void R_ClearPlanes (void)
     lastopening = openings;
     
     // texture calculation
-    memset (cachedheight, 0, sizeof(cachedheight));
+    memset (cachedheight, 0, SCREENHEIGHT * sizeof(*cachedheight));
 
     // left to right mapping
     angle = (viewangle-ANG90)>>ANGLETOFINESHIFT;
@@ -246,7 +362,7 @@ R_FindPlane
     check->minx = SCREENWIDTH;
     check->maxx = -1;
     
-    memset (check->top,0xff,sizeof(check->top));
+    memset (check->top,0xff,SCREENWIDTH * sizeof(*check->top));
 		
     return check;
 }
@@ -290,7 +406,7 @@ R_CheckPlane
     }
 
     for (x=intrl ; x<= intrh ; x++)
-	if (pl->top[x] != 0xff)
+	if (pl->top[x] != 0xffff)
 	    break;
 
     if (x > intrh)
@@ -311,7 +427,7 @@ R_CheckPlane
     pl->minx = start;
     pl->maxx = stop;
 
-    memset (pl->top,0xff,sizeof(pl->top));
+    memset (pl->top,0xff,SCREENWIDTH * sizeof(*pl->top));
 		
     return pl;
 }
@@ -353,6 +469,25 @@ R_MakeSpans
 
 
 
+//
+// R_SetupSkyColumns
+// Finds the sky texture column behind each column of the
+//  view, once a frame, before the first sky plane is drawn.
+//
+static void R_SetupSkyColumns (void)
+{
+    int		x;
+    int		angle;
+
+    for (x=0 ; x<viewwidth ; x++)
+    {
+	angle = (viewangle + xtoviewangle[x])>>ANGLETOSKYSHIFT;
+	skycolumns[x] = R_GetColumn(skytexture, angle);
+    }
+}
+
+
+
 //
 // R_DrawPlanes
 // At the end of each frame.
@@ -363,23 +498,23 @@ void R_DrawPlanes (void)
     int			light;
     int			x;
     int			stop;
-    int			angle;
+    boolean		skyready;
     int                 lumpnum;
 				
+    if (ds_p - drawsegs > peakdrawsegs)
+	peakdrawsegs = ds_p - drawsegs;
+
+    if (lastopening - openings > peakopenings)
+	peakopenings = lastopening - openings;
+
 #ifdef RANGECHECK
-    if (ds_p - drawsegs > MAXDRAWSEGS)
-	I_Error ("R_DrawPlanes: drawsegs overflow (%i)",
-		 ds_p - drawsegs);
-    
     if (lastvisplane - visplanes > MAXVISPLANES)
 	I_Error ("R_DrawPlanes: visplane overflow (%i)",
 		 lastvisplane - visplanes);
-    
-    if (lastopening - openings > MAXOPENINGS)
-	I_Error ("R_DrawPlanes: opening overflow (%i)",
-		 lastopening - openings);
 #endif
 
+    skyready = false;
+
     for (pl = visplanes ; pl < lastvisplane ; pl++)
     {
 	if (pl->minx > pl->maxx)
@@ -389,14 +524,17 @@ void R_DrawPlanes (void)
 	// sky flat
 	if (pl->picnum == skyflatnum)
 	{
-	    dc_iscale = pspriteiscale>>detailshift;
-	    
+	    if (!skyready)
+	    {
+		R_SetupSkyColumns ();
+		skyready = true;
+	    }
+
 	    // Sky is allways drawn full bright,
 	    //  i.e. colormaps[0] is used.
 	    // Because of this hack, sky is not affected
 	    //  by INVUL inverse mapping.
 	    dc_colormap = colormaps;
-	    dc_texturemid = skytexturemid;
 	    for (x=pl->minx ; x <= pl->maxx ; x++)
 	    {
 		dc_yl = pl->top[x];
@@ -404,10 +542,9 @@ void R_DrawPlanes (void)
 
 		if (dc_yl <= dc_yh)
 		{
-		    angle = (viewangle + xtoviewangle[x])>>ANGLETOSKYSHIFT;
 		    dc_x = x;
-		    dc_source = R_GetColumn(skytexture, angle);
-		    colfunc ();
+		    dc_source = skycolumns[x];
+		    skycolfunc ();
 		}
 	    }
 	    continue;
@@ -428,8 +565,8 @@ void R_DrawPlanes (void)
 
 	planezlight = zlight[light];
 
-	pl->top[pl->maxx+1] = 0xff;
-	pl->top[pl->minx-1] = 0xff;
+	pl->top[pl->maxx+1] = 0xffff;
+	pl->top[pl->minx-1] = 0xffff;
 		
 	stop = pl->maxx + 1;
 
@@ -441,6 +578,6 @@ void R_DrawPlanes (void)
 			pl->bottom[x]);
 	}
 	
-        W_ReleaseLumpNum(lumpnum);
+        R_ReleaseDrawLump(lumpnum);
     }
 }
@@ -27,6 +27,8 @@
 
 // Visplane related.
 extern  short*		lastopening;
+extern  int		maxopenings;
+extern  int		peakopenings;
 
 
 typedef void (*planefunction_t) (int top, int bottom);
@@ -34,14 +36,15 @@ typedef void (*planefunction_t) (int top, int bottom);
 extern planefunction_t	floorfunc;
 extern planefunction_t	ceilingfunc_t;
 
-extern short		floorclip[SCREENWIDTH];
-extern short		ceilingclip[SCREENWIDTH];
+extern short*		floorclip;
+extern short*		ceilingclip;
 
-extern fixed_t		yslope[SCREENHEIGHT];
-extern fixed_t		distscale[SCREENWIDTH];
+extern fixed_t*		yslope;
+extern fixed_t*		distscale;
 
 void R_InitPlanes (void);
 void R_ClearPlanes (void);
+void R_CheckOpenings (int needed);
 
 void
 R_MapPlane
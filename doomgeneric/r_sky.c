@@ -28,6 +28,10 @@
 // Needed for Flat retrieval.
 #include "r_data.h"
 
+#include "z_zone.h"
+#include "i_video.h"
+#include "r_local.h"
+
 
 #include "r_sky.h"
 
@@ -38,6 +42,9 @@ int			skyflatnum;
 int			skytexture;
 int			skytexturemid;
 
+// Texture row of the sky for each row of the view.
+byte*			skyrows;
+
 
 
 //
@@ -50,3 +57,20 @@ void R_InitSkyMap (void)
     skytexturemid = 100*FRACUNIT;
 }
 
+
+//
+// R_SetSkyScale
+// Called by R_ExecuteSetViewSize. The sky is always drawn
+//  at the same scale, so the texture row each row of the
+//  view shows is worked out here, once.
+//
+void R_SetSkyScale (fixed_t iscale)
+{
+    int		y;
+
+    if (skyrows == NULL)
+	skyrows = Z_Malloc (SCREENHEIGHT, PU_STATIC, NULL);
+
+    for (y=0 ; y<viewheight ; y++)
+	skyrows[y] = ((skytexturemid + (y-centery)*iscale)>>FRACBITS)&127;
+}
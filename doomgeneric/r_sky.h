@@ -31,7 +31,13 @@
 extern  int		skytexture;
 extern int		skytexturemid;
 
+// Texture row of the sky for each row of the view.
+extern byte*		skyrows;
+
 // Called whenever the view size changes.
 void R_InitSkyMap (void);
 
+// Called whenever the view size changes.
+void R_SetSkyScale (fixed_t iscale);
+
 #endif
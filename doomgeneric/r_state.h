@@ -43,6 +43,9 @@ extern fixed_t*		spritewidth;
 extern fixed_t*		spriteoffset;
 extern fixed_t*		spritetopoffset;
 
+// set once a sprite lump's sizes are in the tables above
+extern byte*		spritelumpready;
+
 extern lighttable_t*	colormaps;
 
 extern int		viewwidth;
@@ -83,6 +86,11 @@ extern subsector_t*	subsectors;
 
 extern int		numnodes;
 extern node_t*		nodes;
+extern nodebox_t*	nodeboxes;
+
+// Room for one entry per level of the BSP tree, for walks
+// that keep an explicit stack instead of recursing.
+extern int*		bspstack;
 
 extern int		numlines;
 extern line_t*		lines;
@@ -106,7 +114,7 @@ extern player_t*	viewplayer;
 extern angle_t		clipangle;
 
 extern int		viewangletox[FINEANGLES/2];
-extern angle_t		xtoviewangle[SCREENWIDTH+1];
+extern angle_t*		xtoviewangle;
 //extern fixed_t		finetangent[FINEANGLES/2];
 
 extern fixed_t		rw_distance;
@@ -72,8 +72,12 @@ lighttable_t**	spritelights;
 
 // constant arrays
 //  used for psprite clipping and initializing clipping
-short		negonearray[SCREENWIDTH];
-short		screenheightarray[SCREENWIDTH];
+short*		negonearray;
+short*		screenheightarray;
+
+// sprite clipping, filled in by R_DrawSprite
+static short*	clipbot;
+static short*	cliptop;
 
 
 //
@@ -291,7 +295,13 @@ int		newvissprite;
 void R_InitSprites (char** namelist)
 {
     int		i;
-	
+
+    negonearray = Z_Malloc (SCREENWIDTH * sizeof(*negonearray), PU_STATIC, NULL);
+    screenheightarray = Z_Malloc (SCREENWIDTH * sizeof(*screenheightarray),
+				  PU_STATIC, NULL);
+    clipbot = Z_Malloc (SCREENWIDTH * sizeof(*clipbot), PU_STATIC, NULL);
+    cliptop = Z_Malloc (SCREENWIDTH * sizeof(*cliptop), PU_STATIC, NULL);
+
     for (i=0 ; i<SCREENWIDTH ; i++)
     {
 	negonearray[i] = -1;
@@ -340,43 +350,68 @@ short*		mceilingclip;
 fixed_t		spryscale;
 fixed_t		sprtopscreen;
 
-void R_DrawMaskedColumn (column_t* column)
+//
+// R_DrawMaskedPost
+// Draws the run of opaque pixels starting topdelta rows down the
+// column, with dc_texturemid left as it was.
+//
+static void
+R_DrawMaskedPost
+( int		topdelta,
+  int		length,
+  byte*		pixels )
 {
     int		topscreen;
     int 	bottomscreen;
     fixed_t	basetexturemid;
-	
-    basetexturemid = dc_texturemid;
-	
-    for ( ; column->topdelta != 0xff ; ) 
-    {
-	// calculate unclipped screen coordinates
-	//  for post
-	topscreen = sprtopscreen + spryscale*column->topdelta;
-	bottomscreen = topscreen + spryscale*column->length;
 
-	dc_yl = (topscreen+FRACUNIT-1)>>FRACBITS;
-	dc_yh = (bottomscreen-1)>>FRACBITS;
+    // calculate unclipped screen coordinates
+    //  for post
+    topscreen = sprtopscreen + spryscale*topdelta;
+    bottomscreen = topscreen + spryscale*length;
+
+    dc_yl = (topscreen+FRACUNIT-1)>>FRACBITS;
+    dc_yh = (bottomscreen-1)>>FRACBITS;
 		
-	if (dc_yh >= mfloorclip[dc_x])
-	    dc_yh = mfloorclip[dc_x]-1;
-	if (dc_yl <= mceilingclip[dc_x])
-	    dc_yl = mceilingclip[dc_x]+1;
+    if (dc_yh >= mfloorclip[dc_x])
+	dc_yh = mfloorclip[dc_x]-1;
+    if (dc_yl <= mceilingclip[dc_x])
+	dc_yl = mceilingclip[dc_x]+1;
 
-	if (dc_yl <= dc_yh)
-	{
-	    dc_source = (byte *)column + 3;
-	    dc_texturemid = basetexturemid - (column->topdelta<<FRACBITS);
-	    // dc_source = (byte *)column + 3 - column->topdelta;
+    if (dc_yl <= dc_yh)
+    {
+	basetexturemid = dc_texturemid;
+	dc_source = pixels;
+	dc_texturemid = basetexturemid - (topdelta<<FRACBITS);
 
-	    // Drawn by either R_DrawColumn
-	    //  or (SHADOW) R_DrawFuzzColumn.
-	    colfunc ();	
-	}
+	// Drawn by either R_DrawColumn
+	//  or (SHADOW) R_DrawFuzzColumn.
+	colfunc ();	
+
+	dc_texturemid = basetexturemid;
+    }
+}
+
+
+void R_DrawMaskedColumn (column_t* column)
+{
+    for ( ; column->topdelta != 0xff ; ) 
+    {
+	R_DrawMaskedPost (column->topdelta, column->length,
+			  (byte *)column + 3);
 	column = (column_t *)(  (byte *)column + column->length + 4);
     }
-	
-    dc_texturemid = basetexturemid;
+}
+
+
+//
+// R_DrawMaskedPosts
+// R_DrawMaskedColumn for a column of a decoded patch.
+//
+void R_DrawMaskedPosts (decodedpost_t* post, decodedpost_t* end)
+{
+    for ( ; post < end ; post++)
+	R_DrawMaskedPost (post->topdelta, post->length, post->pixels);
 }
 
 
@@ -391,13 +426,14 @@ R_DrawVisSprite
   int			x1,
   int			x2 )
 {
-    column_t*		column;
     int			texturecolumn;
     fixed_t		frac;
-    patch_t*		patch;
+    decodedpatch_t*	patch;
+    int			lump;
 	
 	
-    patch = W_CacheLumpNum (vis->patch+firstspritelump, PU_CACHE);
+    lump = vis->patch+firstspritelump;
+    patch = V_CachePatchNum (lump, PU_STATIC);
 
     dc_colormap = vis->colormap;
     
@@ -423,15 +459,15 @@ R_DrawVisSprite
     {
 	texturecolumn = frac>>FRACBITS;
 #ifdef RANGECHECK
-	if (texturecolumn < 0 || texturecolumn >= SHORT(patch->width))
+	if (texturecolumn < 0 || texturecolumn >= patch->width)
 	    I_Error ("R_DrawSpriteRange: bad texturecolumn");
 #endif
-	column = (column_t *) ((byte *)patch +
-			       LONG(patch->columnofs[texturecolumn]));
-	R_DrawMaskedColumn (column);
+	R_DrawMaskedPosts (patch->columns[texturecolumn],
+			   patch->columns[texturecolumn+1]);
     }
 
     colfunc = basecolfunc;
+    R_ReleaseDrawLump (lump);
 }
 
 
@@ -522,6 +558,9 @@ void R_ProjectSprite (mobj_t* thing)
 	lump = sprframe->lump[0];
 	flip = (boolean)sprframe->flip[0];
     }
+
+    if (!spritelumpready[lump])
+	R_InitSpriteLump (lump);
     
     // calculate edges of the shape
     tx -= spriteoffset[lump];	
@@ -586,7 +625,7 @@ void R_ProjectSprite (mobj_t* thing)
     else
     {
 	// diminished light
-	index = xscale>>(LIGHTSCALESHIFT-detailshift);
+	index = xscale>>(LIGHTSCALESHIFT+hires-detailshift);
 
 	if (index >= MAXLIGHTSCALE) 
 	    index = MAXLIGHTSCALE-1;
@@ -663,6 +702,9 @@ void R_DrawPSprite (pspdef_t* psp)
 
     lump = sprframe->lump[0];
     flip = (boolean)sprframe->flip[0];
+
+    if (!spritelumpready[lump])
+	R_InitSpriteLump (lump);
     
     // calculate edges of the shape
     tx = psp->sx-160*FRACUNIT;
@@ -832,8 +874,6 @@ void R_SortVisSprites (void)
 //
 // R_DrawSprite
 //
-static short		clipbot[SCREENWIDTH];
-static short		cliptop[SCREENWIDTH];
 void R_DrawSprite (vissprite_t* spr)
 {
     drawseg_t*		ds;
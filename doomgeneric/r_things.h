@@ -30,8 +30,8 @@ extern vissprite_t	vsprsortedhead;
 
 // Constant arrays used for psprite clipping
 //  and initializing clipping.
-extern short		negonearray[SCREENWIDTH];
-extern short		screenheightarray[SCREENWIDTH];
+extern short*		negonearray;
+extern short*		screenheightarray;
 
 // vars for R_DrawMaskedColumn
 extern short*		mfloorclip;
@@ -44,6 +44,7 @@ extern fixed_t		pspriteiscale;
 
 
 void R_DrawMaskedColumn (column_t* column);
+void R_DrawMaskedPosts (decodedpost_t* post, decodedpost_t* end);
 
 
 void R_SortVisSprites (void);
@@ -0,0 +1,510 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Drawing the player view in vertical strips on several threads.
+//	The BSP walk, planes and sprites are still rendered once, on
+//	the main thread, but every column and span they would draw is
+//	recorded instead. Each thread then replays the whole list,
+//	drawing only the part that falls in its own strip of columns.
+//	Draws into a column keep their order, so the result is the
+//	same as drawing everything on one thread.
+//
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#include <stdint.h>
+#endif
+
+#include "i_system.h"
+#include "w_wad.h"
+#include "z_zone.h"
+
+#include "r_local.h"
+
+
+#define MAXDRAWCOMMANDS		4096
+#define MAXFRAMELUMPS		64
+
+
+typedef struct
+{
+    int			x;
+    int			yl;
+    int			yh;
+    fixed_t		iscale;
+    fixed_t		texturemid;
+    byte*		translation;
+    int			fuzzpos;
+} drawcolumn_t;
+
+typedef struct
+{
+    int			y;
+    int			x1;
+    int			x2;
+    fixed_t		xfrac;
+    fixed_t		yfrac;
+    fixed_t		xstep;
+    fixed_t		ystep;
+} drawspan_t;
+
+typedef struct
+{
+    // The drawer to call, R_DrawColumn, R_DrawSpan etc.
+    void		(*func) (void);
+    boolean		isspan;
+
+    lighttable_t*	colormap;
+    byte*		source;
+
+    union
+    {
+	drawcolumn_t	column;
+	drawspan_t	span;
+    } u;
+} drawcommand_t;
+
+
+int			render_threads = 1;
+
+static boolean		recording;
+
+static drawcommand_t*	drawcommands;
+static int		numdrawcommands;
+static int		maxdrawcommands;
+
+// Lumps to release once the strips have been drawn.
+static int*		framelumps;
+static int		numframelumps;
+static int		maxframelumps;
+
+// The drawers set up by R_ExecuteSetViewSize, while the
+// recording functions stand in for them.
+static void		(*drawcolumn) (void);
+static void		(*drawfuzzcolumn) (void);
+static void		(*drawtranscolumn) (void);
+static void		(*drawskycolumn) (void);
+static void		(*drawspan) (void);
+
+// First column of each strip, plus viewwidth at the end.
+static int		stripx[MAXRENDERTHREADS + 1];
+
+#ifdef HAVE_PTHREAD
+static pthread_mutex_t	strip_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t	strip_start = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t	strip_done = PTHREAD_COND_INITIALIZER;
+static unsigned int	strip_frame;
+static int		strips_pending;
+#endif
+
+
+
+//
+// R_NewDrawCommand
+// Returns the next free command, doubling the list when it is full.
+//
+static drawcommand_t* R_NewDrawCommand (void)
+{
+    drawcommand_t*	newcommands;
+    int			newmax;
+
+    if (numdrawcommands == maxdrawcommands)
+    {
+	newmax = maxdrawcommands ? maxdrawcommands * 2 : MAXDRAWCOMMANDS;
+	newcommands = Z_Malloc (newmax * sizeof(*newcommands),
+				PU_STATIC, NULL);
+
+	if (drawcommands != NULL)
+	{
+	    memcpy (newcommands, drawcommands,
+		    numdrawcommands * sizeof(*drawcommands));
+	    Z_Free (drawcommands);
+	}
+
+	drawcommands = newcommands;
+	maxdrawcommands = newmax;
+    }
+
+    return &drawcommands[numdrawcommands++];
+}
+
+
+//
+// R_RecordColumn
+// Stands in for colfunc while a frame is recorded.
+//
+static void R_RecordColumn (void)
+{
+    drawcommand_t*	cmd;
+
+    cmd = R_NewDrawCommand ();
+    cmd->func = drawcolumn;
+    cmd->isspan = false;
+    cmd->colormap = dc_colormap;
+    cmd->source = dc_source;
+    cmd->u.column.x = dc_x;
+    cmd->u.column.yl = dc_yl;
+    cmd->u.column.yh = dc_yh;
+    cmd->u.column.iscale = dc_iscale;
+    cmd->u.column.texturemid = dc_texturemid;
+    cmd->u.column.translation = dc_translation;
+    cmd->u.column.fuzzpos = fuzzpos;
+}
+
+
+//
+// R_RecordFuzzColumn
+// The fuzz drawer steps through the fuzz table from wherever the
+// previous column left it, so its position is recorded and then
+// moved on as if the column had been drawn.
+//
+static void R_RecordFuzzColumn (void)
+{
+    R_RecordColumn ();
+
+    drawcommands[numdrawcommands - 1].func = drawfuzzcolumn;
+
+    R_SkipFuzzColumn ();
+}
+
+
+//
+// R_RecordTranslatedColumn
+//
+static void R_RecordTranslatedColumn (void)
+{
+    R_RecordColumn ();
+
+    drawcommands[numdrawcommands - 1].func = drawtranscolumn;
+}
+
+
+//
+// R_RecordSkyColumn
+//
+static void R_RecordSkyColumn (void)
+{
+    R_RecordColumn ();
+
+    drawcommands[numdrawcommands - 1].func = drawskycolumn;
+}
+
+
+//
+// R_RecordSpan
+//
+static void R_RecordSpan (void)
+{
+    drawcommand_t*	cmd;
+
+    cmd = R_NewDrawCommand ();
+    cmd->func = drawspan;
+    cmd->isspan = true;
+    cmd->colormap = ds_colormap;
+    cmd->source = ds_source;
+    cmd->u.span.y = ds_y;
+    cmd->u.span.x1 = ds_x1;
+    cmd->u.span.x2 = ds_x2;
+    cmd->u.span.xfrac = ds_xfrac;
+    cmd->u.span.yfrac = ds_yfrac;
+    cmd->u.span.xstep = ds_xstep;
+    cmd->u.span.ystep = ds_ystep;
+}
+
+
+//
+// R_StartSpanAt
+// Sets up ds_xfrac and ds_yfrac for a span that is cut to start
+// skip pixels in. The span drawers pack both coordinates into one
+// 32-bit position and step that as a whole, so carries from y into
+// x happen there too; the skipped steps are added to the packed
+// position and it is unpacked again to match.
+//
+static void R_StartSpanAt (drawspan_t* span, int skip)
+{
+    unsigned int	position;
+    unsigned int	step;
+
+    position = (((unsigned int) span->xfrac << 10) & 0xffff0000)
+	     | (((unsigned int) span->yfrac >> 6) & 0x0000ffff);
+    step = (((unsigned int) span->xstep << 10) & 0xffff0000)
+	 | (((unsigned int) span->ystep >> 6) & 0x0000ffff);
+
+    position += (unsigned int) skip * step;
+
+    ds_xfrac = (fixed_t) ((position >> 16) << 6);
+    ds_yfrac = (fixed_t) ((position & 0xffff) << 6);
+}
+
+
+//
+// R_DrawStrip
+// Draws the part of the recorded frame that falls in a strip.
+//
+static void R_DrawStrip (int strip)
+{
+    drawcommand_t*	cmd;
+    drawcommand_t*	end;
+    int			start;
+    int			stop;
+
+    start = stripx[strip];
+    stop = stripx[strip + 1] - 1;
+    end = drawcommands + numdrawcommands;
+
+    for (cmd = drawcommands ; cmd < end ; cmd++)
+    {
+	if (!cmd->isspan)
+	{
+	    if (cmd->u.column.x < start || cmd->u.column.x > stop)
+		continue;
+
+	    dc_colormap = cmd->colormap;
+	    dc_source = cmd->source;
+	    dc_x = cmd->u.column.x;
+	    dc_yl = cmd->u.column.yl;
+	    dc_yh = cmd->u.column.yh;
+	    dc_iscale = cmd->u.column.iscale;
+	    dc_texturemid = cmd->u.column.texturemid;
+	    dc_translation = cmd->u.column.translation;
+	    fuzzpos = cmd->u.column.fuzzpos;
+	}
+	else
+	{
+	    if (cmd->u.span.x2 < start || cmd->u.span.x1 > stop)
+		continue;
+
+	    ds_colormap = cmd->colormap;
+	    ds_source = cmd->source;
+	    ds_y = cmd->u.span.y;
+	    ds_x1 = cmd->u.span.x1;
+	    ds_x2 = cmd->u.span.x2;
+	    ds_xfrac = cmd->u.span.xfrac;
+	    ds_yfrac = cmd->u.span.yfrac;
+	    ds_xstep = cmd->u.span.xstep;
+	    ds_ystep = cmd->u.span.ystep;
+
+	    if (ds_x1 < start)
+	    {
+		R_StartSpanAt (&cmd->u.span, start - ds_x1);
+		ds_x1 = start;
+	    }
+
+	    if (ds_x2 > stop)
+		ds_x2 = stop;
+	}
+
+	cmd->func ();
+    }
+}
+
+
+#ifdef HAVE_PTHREAD
+
+//
+// R_StripThread
+// Draws its strip of every frame recorded by the main thread.
+//
+static void* R_StripThread (void* arg)
+{
+    int			strip;
+    unsigned int	frame;
+
+    strip = (int) (intptr_t) arg;
+
+    pthread_mutex_lock (&strip_mutex);
+    frame = strip_frame;
+
+    for (;;)
+    {
+	while (strip_frame == frame)
+	    pthread_cond_wait (&strip_start, &strip_mutex);
+
+	frame = strip_frame;
+	pthread_mutex_unlock (&strip_mutex);
+
+	R_DrawStrip (strip);
+
+	pthread_mutex_lock (&strip_mutex);
+
+	if (--strips_pending == 0)
+	    pthread_cond_signal (&strip_done);
+    }
+
+    return NULL;
+}
+
+#endif
+
+
+//
+// R_InitThreads
+//
+void R_InitThreads (void)
+{
+#ifdef HAVE_PTHREAD
+    pthread_t		thread;
+    int			i;
+#endif
+
+    if (render_threads < 1)
+	render_threads = 1;
+
+    if (render_threads > MAXRENDERTHREADS)
+	render_threads = MAXRENDERTHREADS;
+
+#ifdef HAVE_PTHREAD
+    for (i=1 ; i<render_threads ; i++)
+    {
+	if (pthread_create (&thread, NULL, R_StripThread,
+			    (void*) (intptr_t) i) != 0)
+	{
+	    // Draw the strips that do have a thread.
+	    printf ("R_InitThreads: only %i of %i threads started\n",
+		    i, render_threads);
+	    render_threads = i;
+	    break;
+	}
+
+	pthread_detach (thread);
+    }
+#else
+    if (render_threads > 1)
+    {
+	printf ("R_InitThreads: built without thread support, "
+		"drawing on one thread\n");
+	render_threads = 1;
+    }
+#endif
+}
+
+
+//
+// R_BeginStrips
+//
+void R_BeginStrips (void)
+{
+    if (render_threads < 2)
+	return;
+
+    drawcolumn = basecolfunc;
+    drawfuzzcolumn = fuzzcolfunc;
+    drawtranscolumn = transcolfunc;
+    drawskycolumn = skycolfunc;
+    drawspan = spanfunc;
+
+    colfunc = basecolfunc = R_RecordColumn;
+    fuzzcolfunc = R_RecordFuzzColumn;
+    transcolfunc = R_RecordTranslatedColumn;
+    skycolfunc = R_RecordSkyColumn;
+    spanfunc = R_RecordSpan;
+
+    numdrawcommands = 0;
+    recording = true;
+}
+
+
+//
+// R_DrawStrips
+//
+void R_DrawStrips (void)
+{
+    int		i;
+    int		savedfuzzpos;
+
+    if (!recording)
+	return;
+
+    recording = false;
+
+    colfunc = basecolfunc = drawcolumn;
+    fuzzcolfunc = drawfuzzcolumn;
+    transcolfunc = drawtranscolumn;
+    skycolfunc = drawskycolumn;
+    spanfunc = drawspan;
+
+    for (i=0 ; i<=render_threads ; i++)
+	stripx[i] = viewwidth * i / render_threads;
+
+#ifdef HAVE_PTHREAD
+    pthread_mutex_lock (&strip_mutex);
+    strips_pending = render_threads - 1;
+    strip_frame++;
+    pthread_cond_broadcast (&strip_start);
+    pthread_mutex_unlock (&strip_mutex);
+#endif
+
+    // The main thread draws the first strip itself. Recording has
+    // already moved fuzzpos on for the whole frame, so keep that.
+    savedfuzzpos = fuzzpos;
+    R_DrawStrip (0);
+    fuzzpos = savedfuzzpos;
+
+#ifdef HAVE_PTHREAD
+    pthread_mutex_lock (&strip_mutex);
+
+    while (strips_pending > 0)
+	pthread_cond_wait (&strip_done, &strip_mutex);
+
+    pthread_mutex_unlock (&strip_mutex);
+#endif
+
+    for (i=0 ; i<numframelumps ; i++)
+	W_ReleaseLumpNum (framelumps[i]);
+
+    numframelumps = 0;
+}
+
+
+//
+// R_ReleaseDrawLump
+// Releases the lump now when drawing on one thread. Otherwise its
+// pixels have only been recorded, so the release waits until the
+// strips have been drawn and the lump cannot be purged before then.
+//
+void R_ReleaseDrawLump (int lump)
+{
+    int*	newlumps;
+    int		newmax;
+
+    if (!recording)
+    {
+	W_ReleaseLumpNum (lump);
+	return;
+    }
+
+    if (numframelumps == maxframelumps)
+    {
+	newmax = maxframelumps ? maxframelumps * 2 : MAXFRAMELUMPS;
+	newlumps = Z_Malloc (newmax * sizeof(*newlumps), PU_STATIC, NULL);
+
+	if (framelumps != NULL)
+	{
+	    memcpy (newlumps, framelumps, numframelumps * sizeof(*framelumps));
+	    Z_Free (framelumps);
+	}
+
+	framelumps = newlumps;
+	maxframelumps = newmax;
+    }
+
+    framelumps[numframelumps++] = lump;
+}
+
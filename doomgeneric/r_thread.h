@@ -0,0 +1,41 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Drawing the player view in vertical strips on several threads.
+//
+
+
+#ifndef __R_THREAD__
+#define __R_THREAD__
+
+#define MAXRENDERTHREADS	16
+
+// Number of threads drawing the player view, including the main
+// thread. 1 draws everything as it is rendered.
+extern int		render_threads;
+
+// Starts the strip drawing threads.
+void R_InitThreads (void);
+
+// Called by R_RenderPlayerView around the rendering of a frame.
+// In between, column and span draws are recorded instead of being
+// drawn; R_DrawStrips then draws them in strips on all threads.
+void R_BeginStrips (void);
+void R_DrawStrips (void);
+
+// Releases a PU_STATIC lump drawn this frame, once it is safe to.
+void R_ReleaseDrawLump (int lump);
+
+#endif
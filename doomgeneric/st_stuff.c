@@ -254,7 +254,7 @@
 #define ST_OUTHEIGHT		1
 
 #define ST_MAPTITLEX \
-    (SCREENWIDTH - ST_MAPWIDTH * ST_CHATFONTWIDTH)
+    (ORIGWIDTH - ST_MAPWIDTH * ST_CHATFONTWIDTH)
 
 #define ST_MAPTITLEY		0
 #define ST_MAPHEIGHT		1
@@ -1411,6 +1411,13 @@ void ST_Stop (void)
 void ST_Init (void)
 {
     ST_loadData();
-    st_backing_screen = (byte *) Z_Malloc(ST_WIDTH * ST_HEIGHT, PU_STATIC, 0);
+#ifdef COLUMN_MAJOR_VIDEO
+    // Addressed like the framebuffer, so each column is full height.
+    st_backing_screen = (byte *) Z_Malloc(SCREENWIDTH * SCREENHEIGHT,
+                                          PU_STATIC, 0);
+#else
+    st_backing_screen = (byte *) Z_Malloc((ST_WIDTH << hires) * (ST_HEIGHT << hires),
+                                          PU_STATIC, 0);
+#endif
 }
 
@@ -0,0 +1,309 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Patches decoded into native post runs, so that drawing them
+//	does not walk the column offsets and post headers of the lump.
+//
+
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "doomtype.h"
+#include "i_swap.h"
+#include "i_system.h"
+#include "v_patch.h"
+#include "w_wad.h"
+
+
+//
+// Decoded patches are kept in an arena of their own rather than in
+// the zone. Decoding one then never purges a cached lump that a
+// caller is still holding, such as a patch drawn in a loop.
+// The arena holds only the post tables; the pixels stay in the
+// lump, cached or mapped, so emptying it costs a decode but never
+// a read. It is emptied when it grows past PATCHARENALIMIT.
+//
+// The arena is malloc'd outside the zone, so -mb does not count
+// it: budget PATCHARENALIMIT plus one chunk on top of the zone.
+// On a 32 bit target a post takes 12 bytes and a column 4, about
+// 1 KB for a sprite frame, so the limit holds several hundred.
+//
+#define PATCHCHUNKSIZE		(64*1024)
+#define PATCHARENALIMIT		(8*PATCHCHUNKSIZE)
+
+typedef struct patchchunk_s
+{
+    struct patchchunk_s*	next;
+    size_t			size;
+    size_t			used;
+} patchchunk_t;
+
+static patchchunk_t*	patchchunks;
+static size_t		patcharenasize;
+
+// Decoded patch of each lump, or NULL.
+static decodedpatch_t**	decodedpatches;
+static unsigned int	numdecodedpatches;
+
+#define ALIGNPATCH(n)	(((n) + 7) & ~(size_t) 7)
+
+
+//
+// V_FlushPatches
+// Empties the arena, keeping its first chunk.
+//
+static void V_FlushPatches (void)
+{
+    patchchunk_t*	chunk;
+    patchchunk_t*	next;
+
+    if (patchchunks == NULL)
+	return;
+
+    for (chunk = patchchunks->next ; chunk != NULL ; chunk = next)
+    {
+	next = chunk->next;
+	free (chunk);
+    }
+
+    patchchunks->next = NULL;
+    patchchunks->used = 0;
+    patcharenasize = patchchunks->size;
+
+    memset (decodedpatches, 0, numdecodedpatches * sizeof(*decodedpatches));
+}
+
+
+//
+// V_PatchSpace
+// Returns room for at least size bytes at the end of the arena,
+// without taking it.
+//
+static byte* V_PatchSpace (size_t size)
+{
+    patchchunk_t*	chunk;
+    size_t		chunksize;
+
+    chunk = patchchunks;
+
+    if (chunk == NULL || chunk->size - chunk->used < size)
+    {
+	chunksize = ALIGNPATCH(sizeof(patchchunk_t)) + size;
+
+	if (chunksize < PATCHCHUNKSIZE)
+	    chunksize = PATCHCHUNKSIZE;
+
+	chunk = malloc (chunksize);
+
+	if (chunk == NULL)
+	    I_Error ("V_PatchSpace: failed on allocation of %i bytes",
+		     (int) chunksize);
+
+	chunk->next = patchchunks;
+	chunk->size = chunksize - ALIGNPATCH(sizeof(patchchunk_t));
+	chunk->used = 0;
+	patchchunks = chunk;
+	patcharenasize += chunk->size;
+    }
+
+    return (byte *) chunk + ALIGNPATCH(sizeof(patchchunk_t)) + chunk->used;
+}
+
+
+//
+// V_NextPost
+// Returns the offset of the post after the one at ofs, or -1 at
+// the end of the column. A post running off the end of the lump
+// ends the column too.
+//
+static int V_NextPost (byte* data, int length, int ofs)
+{
+    ofs += data[ofs+1] + 4;
+
+    if (ofs + 1 >= length || data[ofs] == 0xff
+     || ofs + 3 + data[ofs+1] > length)
+	return -1;
+
+    return ofs;
+}
+
+
+//
+// V_FirstPost
+//
+static int V_FirstPost (byte* data, int length, int x)
+{
+    int		ofs;
+
+    ofs = LONG(((patch_t *) data)->columnofs[x]);
+
+    if (ofs < 0 || ofs + 1 >= length || data[ofs] == 0xff
+     || ofs + 3 + data[ofs+1] > length)
+	return -1;
+
+    return ofs;
+}
+
+
+//
+// V_DecodePatch
+// The decoded columns point at the posts in data, the lump's
+// cached or mapped bytes. Pixel rows are then the same bytes
+// that drawing from the lump would have read.
+//
+static decodedpatch_t* V_DecodePatch (int lump, byte* data)
+{
+    patch_t*		raw;
+    decodedpatch_t*	patch;
+    decodedpost_t*	post;
+    int			length;
+    int			width;
+    int			numposts;
+    int			ofs;
+    int			x;
+    size_t		size;
+
+    length = W_LumpLength (lump);
+    raw = (patch_t *) data;
+
+    width = length < 8 ? -1 : SHORT(raw->width);
+
+    if (width < 0 || 8 + width * 4 > length)
+	I_Error ("V_DecodePatch: lump %i is not a patch", lump);
+
+    numposts = 0;
+
+    for (x=0 ; x<width ; x++)
+    {
+	for (ofs = V_FirstPost (data, length, x) ; ofs >= 0 ;
+	     ofs = V_NextPost (data, length, ofs))
+	    numposts++;
+    }
+
+    size = ALIGNPATCH(sizeof(decodedpatch_t))
+	 + (width + 1) * sizeof(decodedpost_t*)
+	 + numposts * sizeof(decodedpost_t);
+
+    patch = (decodedpatch_t *) V_PatchSpace (size);
+    patch->width = width;
+    patch->height = SHORT(raw->height);
+    patch->leftoffset = SHORT(raw->leftoffset);
+    patch->topoffset = SHORT(raw->topoffset);
+    patch->data = data;
+    patch->columns = (decodedpost_t **) ((byte *) patch
+				 + ALIGNPATCH(sizeof(decodedpatch_t)));
+
+    post = (decodedpost_t *) (patch->columns + width + 1);
+
+    for (x=0 ; x<width ; x++)
+    {
+	patch->columns[x] = post;
+
+	for (ofs = V_FirstPost (data, length, x) ; ofs >= 0 ;
+	     ofs = V_NextPost (data, length, ofs))
+	{
+	    post->topdelta = data[ofs];
+	    post->length = data[ofs+1];
+	    post->pixels = data + ofs + 3;
+	    post++;
+	}
+    }
+
+    patch->columns[width] = post;
+    patchchunks->used = ALIGNPATCH(patchchunks->used + size);
+
+    return patch;
+}
+
+
+//
+// V_PatchAt
+// Returns the decoded patch of a lump whose data is now at data,
+// moving its posts there if the lump was purged and read again.
+//
+static decodedpatch_t* V_PatchAt (int lump, byte* data)
+{
+    decodedpatch_t**	newpatches;
+    decodedpatch_t*	patch;
+    decodedpost_t*	post;
+    uintptr_t		olddata;
+
+    if (numdecodedpatches < numlumps)
+    {
+	newpatches = realloc (decodedpatches,
+			      numlumps * sizeof(*decodedpatches));
+
+	if (newpatches == NULL)
+	    I_Error ("V_PatchAt: failed to grow the patch table");
+
+	memset (newpatches + numdecodedpatches, 0,
+		(numlumps - numdecodedpatches) * sizeof(*newpatches));
+
+	decodedpatches = newpatches;
+	numdecodedpatches = numlumps;
+    }
+
+    patch = decodedpatches[lump];
+
+    if (patch == NULL)
+    {
+	if (patcharenasize > PATCHARENALIMIT)
+	    V_FlushPatches ();
+
+	patch = decodedpatches[lump] = V_DecodePatch (lump, data);
+    }
+    else if (patch->data != data)
+    {
+	olddata = (uintptr_t) patch->data;
+
+	for (post = patch->columns[0] ; post < patch->columns[patch->width] ;
+	     post++)
+	    post->pixels = data + ((uintptr_t) post->pixels - olddata);
+
+	patch->data = data;
+    }
+
+    return patch;
+}
+
+
+//
+// V_CachePatchNum
+//
+decodedpatch_t* V_CachePatchNum (int lump, int tag)
+{
+    if ((unsigned) lump >= numlumps)
+	I_Error ("V_CachePatchNum: %i >= numlumps", lump);
+
+    return V_PatchAt (lump, W_CacheLumpNum (lump, tag));
+}
+
+
+//
+// V_DecodedPatch
+// The lump is found from the address W_CacheLumpNum gave for it.
+//
+decodedpatch_t* V_DecodedPatch (patch_t* patch)
+{
+    int		lump;
+
+    lump = W_LumpForData (patch);
+
+    if (lump < 0)
+	I_Error ("V_DecodedPatch: patch is not a lump");
+
+    return V_PatchAt (lump, (byte *) patch);
+}
@@ -46,5 +46,36 @@ typedef struct
 // column_t is a list of 0 or more post_t, (byte)-1 terminated
 typedef post_t	column_t;
 
+// A post decoded into native form, pointing at its pixels.
+// The pixels keep the padding byte either side of them, as
+// in the lump, since the column drawers can step onto those.
+typedef struct
+{
+    int			topdelta;
+    int			length;
+    byte*		pixels;
+} decodedpost_t;
+
+// A patch with its columns decoded, built once from the lump.
+// The posts of column x run from columns[x] up to columns[x+1].
+typedef struct
+{
+    short		width;
+    short		height;
+    short		leftoffset;
+    short		topoffset;
+    byte*		data;		// the lump the posts point into
+    decodedpost_t**	columns;
+} decodedpatch_t;
+
+// Caches a patch lump with W_CacheLumpNum, and returns its decoded
+// form, decoding it if needed. Its pixels are in the lump, so are
+// only good while the lump is.
+decodedpatch_t* V_CachePatchNum (int lump, int tag);
+
+// Returns the decoded form of patch, which must be the cached
+// (or mapped) data of a lump.
+decodedpatch_t* V_DecodedPatch (patch_t* patch);
+
 #endif 
 
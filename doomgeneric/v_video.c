@@ -91,13 +91,13 @@ void V_CopyRect(int srcx, int srcy, byte *source,
  
 #ifdef RANGECHECK 
     if (srcx < 0
-     || srcx + width > SCREENWIDTH
+     || srcx + width > ORIGWIDTH
      || srcy < 0
-     || srcy + height > SCREENHEIGHT 
+     || srcy + height > ORIGHEIGHT 
      || destx < 0
-     || destx + width > SCREENWIDTH
+     || destx + width > ORIGWIDTH
      || desty < 0
-     || desty + height > SCREENHEIGHT)
+     || desty + height > ORIGHEIGHT)
     {
         I_Error ("Bad V_CopyRect");
     }
@@ -105,15 +105,27 @@ void V_CopyRect(int srcx, int srcy, byte *source,
 
     V_MarkRect(destx, desty, width, height); 
  
-    src = source + SCREENWIDTH * srcy + srcx; 
-    dest = dest_screen + SCREENWIDTH * desty + destx; 
-
+    // Coordinates are in 320x200 units; scale to the framebuffer.
+    src = source + SCREENOFS(srcx << hires, srcy << hires); 
+    dest = dest_screen + SCREENOFS(destx << hires, desty << hires); 
+    width <<= hires;
+    height <<= hires;
+
+#ifdef COLUMN_MAJOR_VIDEO
+    for ( ; width>0 ; width--) 
+    { 
+        memcpy(dest, src, height); 
+        src += SCREENXSTEP; 
+        dest += SCREENXSTEP; 
+    } 
+#else
     for ( ; height>0 ; height--) 
     { 
         memcpy(dest, src, width); 
-        src += SCREENWIDTH; 
-        dest += SCREENWIDTH; 
+        src += SCREENYSTEP; 
+        dest += SCREENYSTEP; 
     } 
+#endif
 } 
  
 //
@@ -134,13 +146,18 @@ void V_SetPatchClipCallback(vpatchclipfunc_t func)
 //
 // V_DrawPatch
 // Masks a column based masked pic to the screen. 
+// Patch coordinates are in 320x200 units; each patch
+//  pixel covers 1 << hires framebuffer pixels each way.
 //
 
 void V_DrawPatch(int x, int y, patch_t *patch)
 { 
     int count;
+    int row;
     int col;
-    column_t *column;
+    decodedpatch_t *decoded;
+    decodedpost_t *post;
+    decodedpost_t *end;
     byte *desttop;
     byte *dest;
     byte *source;
@@ -158,9 +175,9 @@ void V_DrawPatch(int x, int y, patch_t *patch)
 
 #ifdef RANGECHECK
     if (x < 0
-     || x + SHORT(patch->width) > SCREENWIDTH
+     || x + SHORT(patch->width) > ORIGWIDTH
      || y < 0
-     || y + SHORT(patch->height) > SCREENHEIGHT)
+     || y + SHORT(patch->height) > ORIGHEIGHT)
     {
         I_Error("Bad V_DrawPatch x=%i y=%i patch.width=%i patch.height=%i topoffset=%i leftoffset=%i", x, y, patch->width, patch->height, patch->topoffset, patch->leftoffset);
     }
@@ -169,27 +186,29 @@ void V_DrawPatch(int x, int y, patch_t *patch)
     V_MarkRect(x, y, SHORT(patch->width), SHORT(patch->height));
 
     col = 0;
-    desttop = dest_screen + y * SCREENWIDTH + x;
+    desttop = dest_screen + SCREENOFS(x << hires, y << hires);
 
-    w = SHORT(patch->width);
+    decoded = V_DecodedPatch(patch);
+    w = decoded->width;
 
-    for ( ; col<w ; x++, col++, desttop++)
+    for ( ; col < (w << hires); x++, col++, desttop += SCREENXSTEP)
     {
-        column = (column_t *)((byte *)patch + LONG(patch->columnofs[col]));
+        post = decoded->columns[col >> hires];
+        end = decoded->columns[(col >> hires) + 1];
 
         // step through the posts in a column
-        while (column->topdelta != 0xff)
+        for ( ; post < end; post++)
         {
-            source = (byte *)column + 3;
-            dest = desttop + column->topdelta*SCREENWIDTH;
-            count = column->length;
+            source = post->pixels;
+            dest = desttop + SCREENOFS(0, post->topdelta << hires);
+            count = post->length << hires;
+            row = 0;
 
             while (count--)
             {
-                *dest = *source++;
-                dest += SCREENWIDTH;
+                *dest = source[row++ >> hires];
+                dest += SCREENYSTEP;
             }
-            column = (column_t *)((byte *)column + column->length + 4);
         }
     }
 }
@@ -203,8 +222,11 @@ void V_DrawPatch(int x, int y, patch_t *patch)
 void V_DrawPatchFlipped(int x, int y, patch_t *patch)
 {
     int count;
+    int row;
     int col; 
-    column_t *column; 
+    decodedpatch_t *decoded;
+    decodedpost_t *post;
+    decodedpost_t *end;
     byte *desttop;
     byte *dest;
     byte *source; 
@@ -222,9 +244,9 @@ void V_DrawPatchFlipped(int x, int y, patch_t *patch)
 
 #ifdef RANGECHECK 
     if (x < 0
-     || x + SHORT(patch->width) > SCREENWIDTH
+     || x + SHORT(patch->width) > ORIGWIDTH
      || y < 0
-     || y + SHORT(patch->height) > SCREENHEIGHT)
+     || y + SHORT(patch->height) > ORIGHEIGHT)
     {
         I_Error("Bad V_DrawPatchFlipped");
     }
@@ -233,27 +255,29 @@ void V_DrawPatchFlipped(int x, int y, patch_t *patch)
     V_MarkRect (x, y, SHORT(patch->width), SHORT(patch->height));
 
     col = 0;
-    desttop = dest_screen + y * SCREENWIDTH + x;
+    desttop = dest_screen + SCREENOFS(x << hires, y << hires);
 
-    w = SHORT(patch->width);
+    decoded = V_DecodedPatch(patch);
+    w = decoded->width;
 
-    for ( ; col<w ; x++, col++, desttop++)
+    for ( ; col < (w << hires); x++, col++, desttop += SCREENXSTEP)
     {
-        column = (column_t *)((byte *)patch + LONG(patch->columnofs[w-1-col]));
+        post = decoded->columns[w-1-(col >> hires)];
+        end = decoded->columns[w-1-(col >> hires) + 1];
 
         // step through the posts in a column
-        while (column->topdelta != 0xff )
+        for ( ; post < end; post++)
         {
-            source = (byte *)column + 3;
-            dest = desttop + column->topdelta*SCREENWIDTH;
-            count = column->length;
+            source = post->pixels;
+            dest = desttop + SCREENOFS(0, post->topdelta << hires);
+            count = post->length << hires;
+            row = 0;
 
             while (count--)
             {
-                *dest = *source++;
-                dest += SCREENWIDTH;
+                *dest = source[row++ >> hires];
+                dest += SCREENYSTEP;
             }
-            column = (column_t *)((byte *)column + column->length + 4);
         }
     }
 }
@@ -278,7 +302,7 @@ void V_DrawPatchDirect(int x, int y, patch_t *patch)
 
 void V_DrawTLPatch(int x, int y, patch_t * patch)
 {
-    int count, col;
+    int count, row, col;
     column_t *column;
     byte *desttop, *dest, *source;
     int w;
@@ -287,33 +311,34 @@ void V_DrawTLPatch(int x, int y, patch_t * patch)
     x -= SHORT(patch->leftoffset);
 
     if (x < 0
-     || x + SHORT(patch->width) > SCREENWIDTH 
+     || x + SHORT(patch->width) > ORIGWIDTH 
      || y < 0
-     || y + SHORT(patch->height) > SCREENHEIGHT)
+     || y + SHORT(patch->height) > ORIGHEIGHT)
     {
         I_Error("Bad V_DrawTLPatch");
     }
 
     col = 0;
-    desttop = dest_screen + y * SCREENWIDTH + x;
+    desttop = dest_screen + SCREENOFS(x << hires, y << hires);
 
     w = SHORT(patch->width);
-    for (; col < w; x++, col++, desttop++)
+    for (; col < (w << hires); x++, col++, desttop += SCREENXSTEP)
     {
-        column = (column_t *) ((byte *) patch + LONG(patch->columnofs[col]));
+        column = (column_t *) ((byte *) patch + LONG(patch->columnofs[col >> hires]));
 
         // step through the posts in a column
 
         while (column->topdelta != 0xff)
         {
             source = (byte *) column + 3;
-            dest = desttop + column->topdelta * SCREENWIDTH;
-            count = column->length;
+            dest = desttop + SCREENOFS(0, column->topdelta << hires);
+            count = column->length << hires;
+            row = 0;
 
             while (count--)
             {
-                *dest = tinttable[((*dest) << 8) + *source++];
-                dest += SCREENWIDTH;
+                *dest = tinttable[((*dest) << 8) + source[row++ >> hires]];
+                dest += SCREENYSTEP;
             }
             column = (column_t *) ((byte *) column + column->length + 4);
         }
@@ -328,7 +353,7 @@ void V_DrawTLPatch(int x, int y, patch_t * patch)
 
 void V_DrawXlaPatch(int x, int y, patch_t * patch)
 {
-    int count, col;
+    int count, row, col;
     column_t *column;
     byte *desttop, *dest, *source;
     int w;
@@ -343,26 +368,26 @@ void V_DrawXlaPatch(int x, int y, patch_t * patch)
     }
 
     col = 0;
-    desttop = dest_screen + y * SCREENWIDTH + x;
+    desttop = dest_screen + SCREENOFS(x << hires, y << hires);
 
     w = SHORT(patch->width);
-    for(; col < w; x++, col++, desttop++)
+    for(; col < (w << hires); x++, col++, desttop += SCREENXSTEP)
     {
-        column = (column_t *) ((byte *) patch + LONG(patch->columnofs[col]));
+        column = (column_t *) ((byte *) patch + LONG(patch->columnofs[col >> hires]));
 
         // step through the posts in a column
 
         while(column->topdelta != 0xff)
         {
             source = (byte *) column + 3;
-            dest = desttop + column->topdelta * SCREENWIDTH;
-            count = column->length;
+            dest = desttop + SCREENOFS(0, column->topdelta << hires);
+            count = column->length << hires;
+            row = 0;
 
             while(count--)
             {
-                *dest = xlatab[*dest + ((*source) << 8)];
-                source++;
-                dest += SCREENWIDTH;
+                *dest = xlatab[*dest + (source[row++ >> hires] << 8)];
+                dest += SCREENYSTEP;
             }
             column = (column_t *) ((byte *) column + column->length + 4);
         }
@@ -377,7 +402,7 @@ void V_DrawXlaPatch(int x, int y, patch_t * patch)
 
 void V_DrawAltTLPatch(int x, int y, patch_t * patch)
 {
-    int count, col;
+    int count, row, col;
     column_t *column;
     byte *desttop, *dest, *source;
     int w;
@@ -386,33 +411,34 @@ void V_DrawAltTLPatch(int x, int y, patch_t * patch)
     x -= SHORT(patch->leftoffset);
 
     if (x < 0
-     || x + SHORT(patch->width) > SCREENWIDTH
+     || x + SHORT(patch->width) > ORIGWIDTH
      || y < 0
-     || y + SHORT(patch->height) > SCREENHEIGHT)
+     || y + SHORT(patch->height) > ORIGHEIGHT)
     {
         I_Error("Bad V_DrawAltTLPatch");
     }
 
     col = 0;
-    desttop = dest_screen + y * SCREENWIDTH + x;
+    desttop = dest_screen + SCREENOFS(x << hires, y << hires);
 
     w = SHORT(patch->width);
-    for (; col < w; x++, col++, desttop++)
+    for (; col < (w << hires); x++, col++, desttop += SCREENXSTEP)
     {
-        column = (column_t *) ((byte *) patch + LONG(patch->columnofs[col]));
+        column = (column_t *) ((byte *) patch + LONG(patch->columnofs[col >> hires]));
 
         // step through the posts in a column
 
         while (column->topdelta != 0xff)
         {
             source = (byte *) column + 3;
-            dest = desttop + column->topdelta * SCREENWIDTH;
-            count = column->length;
+            dest = desttop + SCREENOFS(0, column->topdelta << hires);
+            count = column->length << hires;
+            row = 0;
 
             while (count--)
             {
-                *dest = tinttable[((*dest) << 8) + *source++];
-                dest += SCREENWIDTH;
+                *dest = tinttable[((*dest) << 8) + source[row++ >> hires]];
+                dest += SCREENYSTEP;
             }
             column = (column_t *) ((byte *) column + column->length + 4);
         }
@@ -427,7 +453,7 @@ void V_DrawAltTLPatch(int x, int y, patch_t * patch)
 
 void V_DrawShadowedPatch(int x, int y, patch_t *patch)
 {
-    int count, col;
+    int count, row, col;
     column_t *column;
     byte *desttop, *dest, *source;
     byte *desttop2, *dest2;
@@ -437,37 +463,38 @@ void V_DrawShadowedPatch(int x, int y, patch_t *patch)
     x -= SHORT(patch->leftoffset);
 
     if (x < 0
-     || x + SHORT(patch->width) > SCREENWIDTH
+     || x + SHORT(patch->width) > ORIGWIDTH
      || y < 0
-     || y + SHORT(patch->height) > SCREENHEIGHT)
+     || y + SHORT(patch->height) > ORIGHEIGHT)
     {
         I_Error("Bad V_DrawShadowedPatch");
     }
 
     col = 0;
-    desttop = dest_screen + y * SCREENWIDTH + x;
-    desttop2 = dest_screen + (y + 2) * SCREENWIDTH + x + 2;
+    desttop = dest_screen + SCREENOFS(x << hires, y << hires);
+    desttop2 = dest_screen + SCREENOFS((x + 2) << hires, (y + 2) << hires);
 
     w = SHORT(patch->width);
-    for (; col < w; x++, col++, desttop++, desttop2++)
+    for (; col < (w << hires); x++, col++, desttop += SCREENXSTEP, desttop2 += SCREENXSTEP)
     {
-        column = (column_t *) ((byte *) patch + LONG(patch->columnofs[col]));
+        column = (column_t *) ((byte *) patch + LONG(patch->columnofs[col >> hires]));
 
         // step through the posts in a column
 
         while (column->topdelta != 0xff)
         {
             source = (byte *) column + 3;
-            dest = desttop + column->topdelta * SCREENWIDTH;
-            dest2 = desttop2 + column->topdelta * SCREENWIDTH;
-            count = column->length;
+            dest = desttop + SCREENOFS(0, column->topdelta << hires);
+            dest2 = desttop2 + SCREENOFS(0, column->topdelta << hires);
+            count = column->length << hires;
+            row = 0;
 
             while (count--)
             {
                 *dest2 = tinttable[((*dest2) << 8)];
-                dest2 += SCREENWIDTH;
-                *dest = *source++;
-                dest += SCREENWIDTH;
+                dest2 += SCREENYSTEP;
+                *dest = source[row++ >> hires];
+                dest += SCREENYSTEP;
 
             }
             column = (column_t *) ((byte *) column + column->length + 4);
@@ -516,14 +543,24 @@ void V_DrawBlock(int x, int y, int width, int height, byte *src)
  
     V_MarkRect (x, y, width, height); 
  
-    dest = dest_screen + y * SCREENWIDTH + x; 
+    dest = dest_screen + SCREENOFS(x, y); 
 
+    // src holds the block in the same layout as the screen.
+#ifdef COLUMN_MAJOR_VIDEO
+    while (width--) 
+    { 
+	memcpy (dest, src, height); 
+	src += height; 
+	dest += SCREENXSTEP; 
+    } 
+#else
     while (height--) 
     { 
 	memcpy (dest, src, width); 
 	src += width; 
-	dest += SCREENWIDTH; 
+	dest += SCREENYSTEP; 
     } 
+#endif
 } 
 
 void V_DrawFilledBox(int x, int y, int w, int h, int c)
@@ -531,7 +568,7 @@ void V_DrawFilledBox(int x, int y, int w, int h, int c)
     uint8_t *buf, *buf1;
     int x1, y1;
 
-    buf = I_VideoBuffer + SCREENWIDTH * y + x;
+    buf = I_VideoBuffer + SCREENOFS(x, y);
 
     for (y1 = 0; y1 < h; ++y1)
     {
@@ -539,10 +576,11 @@ void V_DrawFilledBox(int x, int y, int w, int h, int c)
 
         for (x1 = 0; x1 < w; ++x1)
         {
-            *buf1++ = c;
+            *buf1 = c;
+            buf1 += SCREENXSTEP;
         }
 
-        buf += SCREENWIDTH;
+        buf += SCREENYSTEP;
     }
 }
 
@@ -551,11 +589,12 @@ void V_DrawHorizLine(int x, int y, int w, int c)
     uint8_t *buf;
     int x1;
 
-    buf = I_VideoBuffer + SCREENWIDTH * y + x;
+    buf = I_VideoBuffer + SCREENOFS(x, y);
 
     for (x1 = 0; x1 < w; ++x1)
     {
-        *buf++ = c;
+        *buf = c;
+        buf += SCREENXSTEP;
     }
 }
 
@@ -564,12 +603,12 @@ void V_DrawVertLine(int x, int y, int h, int c)
     uint8_t *buf;
     int y1;
 
-    buf = I_VideoBuffer + SCREENWIDTH * y + x;
+    buf = I_VideoBuffer + SCREENOFS(x, y);
 
     for (y1 = 0; y1 < h; ++y1)
     {
         *buf = c;
-        buf += SCREENWIDTH;
+        buf += SCREENYSTEP;
     }
 }
 
@@ -588,7 +627,19 @@ void V_DrawBox(int x, int y, int w, int h, int c)
  
 void V_DrawRawScreen(byte *raw)
 {
+#ifdef COLUMN_MAJOR_VIDEO
+    int x, y;
+
+    for (y = 0; y < SCREENHEIGHT; ++y)
+    {
+        for (x = 0; x < SCREENWIDTH; ++x)
+        {
+            dest_screen[SCREENOFS(x, y)] = *raw++;
+        }
+    }
+#else
     memcpy(dest_screen, raw, SCREENWIDTH * SCREENHEIGHT);
+#endif
 }
 
 //
@@ -793,6 +844,7 @@ void V_ScreenShot(char *format)
     int i;
     char lbmname[16]; // haleyjd 20110213: BUG FIX - 12 is too small!
     char *ext;
+    byte *data;
     
     // find a file name to save it to
 
@@ -823,10 +875,29 @@ void V_ScreenShot(char *format)
         I_Error ("V_ScreenShot: Couldn't create a PCX");
     }
 
+    data = I_VideoBuffer;
+
+#ifdef COLUMN_MAJOR_VIDEO
+    {
+        int x, y;
+
+        // The image writers expect rows.
+        data = Z_Malloc(SCREENWIDTH * SCREENHEIGHT, PU_STATIC, NULL);
+
+        for (y = 0; y < SCREENHEIGHT; ++y)
+        {
+            for (x = 0; x < SCREENWIDTH; ++x)
+            {
+                data[y * SCREENWIDTH + x] = I_VideoBuffer[SCREENOFS(x, y)];
+            }
+        }
+    }
+#endif
+
 #ifdef HAVE_LIBPNG
     if (png_screenshots)
     {
-    WritePNGfile(lbmname, I_VideoBuffer,
+    WritePNGfile(lbmname, data,
                  SCREENWIDTH, SCREENHEIGHT,
                  W_CacheLumpName (DEH_String("PLAYPAL"), PU_CACHE));
     }
@@ -834,10 +905,14 @@ void V_ScreenShot(char *format)
 #endif
     {
     // save the pcx file
-    WritePCXfile(lbmname, I_VideoBuffer,
+    WritePCXfile(lbmname, data,
                  SCREENWIDTH, SCREENHEIGHT,
                  W_CacheLumpName (DEH_String("PLAYPAL"), PU_CACHE));
     }
+
+#ifdef COLUMN_MAJOR_VIDEO
+    Z_Free(data);
+#endif
 }
 
 #define MOUSE_SPEED_BOX_WIDTH  120
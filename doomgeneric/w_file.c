@@ -26,6 +26,7 @@
 #include "w_file.h"
 
 extern wad_file_class_t stdc_wad_file;
+extern wad_file_class_t lz_wad_file;
 
 /*
 #ifdef _WIN32
@@ -55,6 +56,16 @@ wad_file_t *W_OpenFile(char *path)
     wad_file_t *result;
     int i;
 
+    // A WAD packed by wadpack is read by its own class, whichever
+    // class would read it otherwise.
+
+    result = lz_wad_file.OpenFile(path);
+
+    if (result != NULL)
+    {
+        return result;
+    }
+
     //!
     // Use the OS's virtual memory subsystem to map WAD files
     // directly into memory.
@@ -93,3 +104,14 @@ size_t W_Read(wad_file_t *wad, unsigned int offset,
     return wad->file_class->Read(wad, offset, buffer, buffer_len);
 }
 
+size_t W_ReadShared(wad_file_t *wad, unsigned int offset,
+                    void *buffer, size_t buffer_len)
+{
+    if (wad->file_class->ReadShared == NULL)
+    {
+        return 0;
+    }
+
+    return wad->file_class->ReadShared(wad, offset, buffer, buffer_len);
+}
+
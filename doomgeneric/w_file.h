@@ -41,6 +41,12 @@ typedef struct
     size_t (*Read)(wad_file_t *file, unsigned int offset,
                    void *buffer, size_t buffer_len);
 
+    // Read as Read does, but from a thread other than the one that
+    // opens, reads and closes the file.  NULL if the class cannot.
+
+    size_t (*ReadShared)(wad_file_t *file, unsigned int offset,
+                         void *buffer, size_t buffer_len);
+
 } wad_file_class_t;
 
 struct _wad_file_s
@@ -75,4 +81,10 @@ void W_CloseFile(wad_file_t *wad);
 size_t W_Read(wad_file_t *wad, unsigned int offset,
               void *buffer, size_t buffer_len);
 
+// As W_Read, from a thread other than the main one.  Returns 0 if
+// the file cannot be read that way.
+
+size_t W_ReadShared(wad_file_t *wad, unsigned int offset,
+                    void *buffer, size_t buffer_len);
+
 #endif /* #ifndef __W_FILE__ */
@@ -0,0 +1,415 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	WAD I/O functions, reading WADs packed by wadpack.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef HAVE_PTHREAD
+#include <errno.h>
+#include <unistd.h>
+#endif
+
+#include "i_swap.h"
+#include "i_system.h"
+#include "w_file.h"
+#include "w_lz.h"
+#include "z_zone.h"
+
+// What a read unpacks through: the file's own buffers for Read,
+// buffers of its own for each ReadShared.
+
+typedef struct
+{
+    boolean shared;
+
+    // Packed data read from the file, sized for the largest chunk.
+    byte *packed;
+
+    // The last chunk unpacked for a read of only part of it.
+    int cachedchunk;
+    byte *cache;
+} lz_reader_t;
+
+typedef struct
+{
+    wad_file_t wad;
+    FILE *fstream;
+
+    int numchunks;
+    lzwadchunk_t *chunks;
+
+    // Largest chunk, packed and unpacked.
+    int maxsize;
+    int maxlength;
+
+    lz_reader_t reader;
+} lz_wad_file_t;
+
+extern wad_file_class_t lz_wad_file;
+
+static wad_file_t *W_LZ_OpenFile(char *path)
+{
+    lz_wad_file_t *result;
+    lzwadinfo_t header;
+    lzwadchunk_t *chunk;
+    FILE *fstream;
+    int length;
+    int i;
+
+    fstream = fopen(path, "rb");
+
+    if (fstream == NULL)
+    {
+        return NULL;
+    }
+
+    // Any other file is for another class.
+
+    if (fread(&header, sizeof(header), 1, fstream) != 1
+     || strncmp(header.identification, LZWAD_ID, 4) != 0)
+    {
+        fclose(fstream);
+        return NULL;
+    }
+
+    result = Z_Malloc(sizeof(lz_wad_file_t), PU_STATIC, 0);
+    result->wad.file_class = &lz_wad_file;
+    result->wad.mapped = NULL;
+    result->wad.length = LONG(header.length);
+    result->fstream = fstream;
+
+    result->numchunks = LONG(header.numchunks);
+
+    if (result->numchunks < 0)
+    {
+        I_Error("W_LZ_OpenFile: bad header in %s", path);
+    }
+
+    result->chunks = Z_Malloc(result->numchunks * sizeof(lzwadchunk_t),
+                              PU_STATIC, 0);
+
+    if (fread(result->chunks, sizeof(lzwadchunk_t), result->numchunks,
+              fstream) != result->numchunks)
+    {
+        I_Error("W_LZ_OpenFile: %s is cut short", path);
+    }
+
+    result->maxsize = 0;
+    result->maxlength = 0;
+
+    for (i = 0, chunk = result->chunks; i < result->numchunks; ++i, ++chunk)
+    {
+        chunk->position = LONG(chunk->position);
+        chunk->filepos = LONG(chunk->filepos);
+        chunk->size = LONG(chunk->size);
+
+        if (i + 1 < result->numchunks)
+        {
+            length = LONG(chunk[1].position) - chunk->position;
+        }
+        else
+        {
+            length = result->wad.length - chunk->position;
+        }
+
+        if ((i == 0 && chunk->position != 0)
+         || length < 0 || length > LZWAD_MAXCHUNK
+         || chunk->size < 0 || chunk->size > LZ_BOUND(length))
+        {
+            I_Error("W_LZ_OpenFile: bad chunk %i in %s", i, path);
+        }
+
+        if (chunk->size > result->maxsize)
+        {
+            result->maxsize = chunk->size;
+        }
+
+        if (length > result->maxlength)
+        {
+            result->maxlength = length;
+        }
+    }
+
+    // Both buffers are kept, rather than allocated when needed, as
+    // a read may be into a purgable block.
+
+    result->reader.shared = false;
+    result->reader.packed = Z_Malloc(result->maxsize + 1, PU_STATIC, 0);
+    result->reader.cachedchunk = -1;
+    result->reader.cache = Z_Malloc(result->maxlength + 1, PU_STATIC, 0);
+
+    return &result->wad;
+}
+
+static void W_LZ_CloseFile(wad_file_t *wad)
+{
+    lz_wad_file_t *lz_wad;
+
+    lz_wad = (lz_wad_file_t *) wad;
+
+    fclose(lz_wad->fstream);
+    Z_Free(lz_wad->reader.cache);
+    Z_Free(lz_wad->reader.packed);
+    Z_Free(lz_wad->chunks);
+    Z_Free(lz_wad);
+}
+
+// Returns the chunk holding the byte at offset.
+
+static int W_LZ_FindChunk(lz_wad_file_t *lz_wad, unsigned int offset)
+{
+    int low, high, mid;
+
+    low = 0;
+    high = lz_wad->numchunks - 1;
+
+    while (low < high)
+    {
+        mid = (low + high + 1) / 2;
+
+        if ((unsigned int) lz_wad->chunks[mid].position <= offset)
+        {
+            low = mid;
+        }
+        else
+        {
+            high = mid - 1;
+        }
+    }
+
+    return low;
+}
+
+// Reads len bytes of packed data at filepos.
+
+static boolean W_LZ_ReadPacked(lz_wad_file_t *lz_wad, lz_reader_t *reader,
+                               int filepos, byte *dest, int len)
+{
+#ifdef HAVE_PTHREAD
+    ssize_t result;
+
+    if (reader->shared)
+    {
+        while (len > 0)
+        {
+            result = pread(fileno(lz_wad->fstream), dest, len, filepos);
+
+            if (result < 0 && errno == EINTR)
+            {
+                continue;
+            }
+
+            if (result <= 0)
+            {
+                return false;
+            }
+
+            dest += result;
+            filepos += result;
+            len -= result;
+        }
+
+        return true;
+    }
+#endif
+
+    return fseek(lz_wad->fstream, filepos, SEEK_SET) == 0
+        && fread(dest, 1, len, lz_wad->fstream) == len;
+}
+
+// Unpacks a chunk of length bytes into dest.  Returns false if it
+// could not be read or is damaged.
+
+static boolean W_LZ_Unpack(lz_wad_file_t *lz_wad, lz_reader_t *reader,
+                           int chunknum, byte *dest, int length)
+{
+    lzwadchunk_t *chunk;
+
+    chunk = &lz_wad->chunks[chunknum];
+
+    // A chunk that would not pack is stored as it is.
+
+    if (chunk->size == length)
+    {
+        return W_LZ_ReadPacked(lz_wad, reader, chunk->filepos, dest, length);
+    }
+
+    return W_LZ_ReadPacked(lz_wad, reader, chunk->filepos, reader->packed,
+                           chunk->size)
+        && LZ_Decompress(reader->packed, chunk->size, dest, length);
+}
+
+// Reads through the given reader.
+
+static size_t W_LZ_ReadWith(lz_wad_file_t *lz_wad, lz_reader_t *reader,
+                            unsigned int offset,
+                            void *buffer, size_t buffer_len)
+{
+    byte *dest;
+    unsigned int start, end;
+    size_t result;
+    boolean unpacked;
+    int chunknum;
+    int count;
+
+    dest = buffer;
+    result = 0;
+
+    if (offset >= lz_wad->wad.length || lz_wad->numchunks == 0)
+    {
+        return 0;
+    }
+
+    if (buffer_len > lz_wad->wad.length - offset)
+    {
+        buffer_len = lz_wad->wad.length - offset;
+    }
+
+    chunknum = W_LZ_FindChunk(lz_wad, offset);
+
+    while (result < buffer_len)
+    {
+        start = lz_wad->chunks[chunknum].position;
+
+        if (chunknum + 1 < lz_wad->numchunks)
+        {
+            end = lz_wad->chunks[chunknum + 1].position;
+        }
+        else
+        {
+            end = lz_wad->wad.length;
+        }
+
+        count = end - offset;
+
+        if (count > buffer_len - result)
+        {
+            count = buffer_len - result;
+        }
+
+        if (offset == start && count == end - start)
+        {
+            // The whole chunk is wanted: a lump, most likely.
+
+            unpacked = W_LZ_Unpack(lz_wad, reader, chunknum, dest, count);
+        }
+        else
+        {
+            unpacked = true;
+
+            if (reader->cachedchunk != chunknum)
+            {
+                reader->cachedchunk = -1;
+                unpacked = W_LZ_Unpack(lz_wad, reader, chunknum,
+                                       reader->cache, end - start);
+
+                if (unpacked)
+                {
+                    reader->cachedchunk = chunknum;
+                }
+            }
+
+            if (unpacked)
+            {
+                memcpy(dest, reader->cache + offset - start, count);
+            }
+        }
+
+        // A shared read stops short rather than ending the game from
+        // another thread; the main thread will find the same fault.
+
+        if (!unpacked)
+        {
+            if (reader->shared)
+            {
+                return result;
+            }
+
+            I_Error("W_LZ_Read: chunk %i is damaged or cut short", chunknum);
+        }
+
+        dest += count;
+        offset += count;
+        result += count;
+        ++chunknum;
+    }
+
+    return result;
+}
+
+// Read data from the specified position in the file into the
+// provided buffer.  Returns the number of bytes read.
+
+static size_t W_LZ_Read(wad_file_t *wad, unsigned int offset,
+                        void *buffer, size_t buffer_len)
+{
+    lz_wad_file_t *lz_wad;
+
+    lz_wad = (lz_wad_file_t *) wad;
+
+    return W_LZ_ReadWith(lz_wad, &lz_wad->reader, offset,
+                         buffer, buffer_len);
+}
+
+#ifdef HAVE_PTHREAD
+
+// Unpacks through buffers of its own, and reads the file with
+// pread(), which leaves the stream and its position alone.
+
+static size_t W_LZ_ReadShared(wad_file_t *wad, unsigned int offset,
+                              void *buffer, size_t buffer_len)
+{
+    lz_wad_file_t *lz_wad;
+    lz_reader_t reader;
+    size_t result;
+
+    lz_wad = (lz_wad_file_t *) wad;
+
+    reader.shared = true;
+    reader.packed = malloc(lz_wad->maxsize + 1);
+    reader.cachedchunk = -1;
+    reader.cache = malloc(lz_wad->maxlength + 1);
+
+    result = 0;
+
+    if (reader.packed != NULL && reader.cache != NULL)
+    {
+        result = W_LZ_ReadWith(lz_wad, &reader, offset, buffer, buffer_len);
+    }
+
+    free(reader.cache);
+    free(reader.packed);
+
+    return result;
+}
+
+#endif
+
+wad_file_class_t lz_wad_file =
+{
+    W_LZ_OpenFile,
+    W_LZ_CloseFile,
+    W_LZ_Read,
+#ifdef HAVE_PTHREAD
+    W_LZ_ReadShared,
+#else
+    NULL,
+#endif
+};
+
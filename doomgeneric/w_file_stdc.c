@@ -18,6 +18,11 @@
 
 #include <stdio.h>
 
+#ifdef HAVE_PTHREAD
+#include <errno.h>
+#include <unistd.h>
+#endif
+
 #include "m_misc.h"
 #include "w_file.h"
 #include "z_zone.h"
@@ -85,12 +90,60 @@ size_t W_StdC_Read(wad_file_t *wad, unsigned int offset,
     return result;
 }
 
+#ifdef HAVE_PTHREAD
+
+// Reads with pread() on the stream's descriptor, which leaves the
+// stream and its position alone.
+
+static size_t W_StdC_ReadShared(wad_file_t *wad, unsigned int offset,
+                                void *buffer, size_t buffer_len)
+{
+    stdc_wad_file_t *stdc_wad;
+    byte *byte_buffer;
+    size_t bytes_read;
+    ssize_t result;
+
+    stdc_wad = (stdc_wad_file_t *) wad;
+
+    byte_buffer = buffer;
+    bytes_read = 0;
+
+    while (buffer_len > 0)
+    {
+        result = pread(fileno(stdc_wad->fstream), byte_buffer, buffer_len,
+                       offset + bytes_read);
+
+        if (result < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (result <= 0)
+        {
+            break;
+        }
+
+        buffer_len -= result;
+        byte_buffer += result;
+        bytes_read += result;
+    }
+
+    return bytes_read;
+}
+
+#endif
+
 
 wad_file_class_t stdc_wad_file = 
 {
     W_StdC_OpenFile,
     W_StdC_CloseFile,
     W_StdC_Read,
+#ifdef HAVE_PTHREAD
+    W_StdC_ReadShared,
+#else
+    NULL,
+#endif
 };
 
 
@@ -0,0 +1,261 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	LZ77 compression of packed WAD chunks.
+//
+
+#include <string.h>
+
+#include "w_lz.h"
+
+//
+// The data is a run of sequences, as in the LZ4 block format.
+// Each is a token byte, holding the number of literal bytes in its
+// top four bits and the match length less 4 in the bottom four,
+// then the literals, then the distance back to the match as two
+// bytes.  A count of 15 goes on in more bytes, up to the first
+// that is not 255.  The last sequence has literals only.
+//
+
+#define MINMATCH	4
+#define MAXDISTANCE	65535
+
+// The last match starts this far from the end of the data, and
+// ends at least LASTLITERALS before it.
+#define MFLIMIT		12
+#define LASTLITERALS	5
+
+#define HASHBITS	14
+
+#define READ32(p)	((p)[0] | ((p)[1] << 8) | ((p)[2] << 16) \
+			 | ((unsigned int) (p)[3] << 24))
+#define HASH32(v)	(((v) * 2654435761u) >> (32 - HASHBITS))
+
+
+static byte *LZ_PutCount(byte *dest, int count)
+{
+    while (count >= 255)
+    {
+        *dest++ = 255;
+        count -= 255;
+    }
+
+    *dest++ = count;
+
+    return dest;
+}
+
+static byte *LZ_PutSequence(byte *dest, const byte *literals, int numliterals,
+                            int distance, int matchlen)
+{
+    byte *token;
+
+    token = dest++;
+    *token = (numliterals < 15 ? numliterals : 15) << 4;
+
+    if (numliterals >= 15)
+    {
+        dest = LZ_PutCount(dest, numliterals - 15);
+    }
+
+    memcpy(dest, literals, numliterals);
+    dest += numliterals;
+
+    if (matchlen == 0)
+    {
+        return dest;
+    }
+
+    *dest++ = distance & 0xff;
+    *dest++ = distance >> 8;
+
+    matchlen -= MINMATCH;
+    *token |= matchlen < 15 ? matchlen : 15;
+
+    if (matchlen >= 15)
+    {
+        dest = LZ_PutCount(dest, matchlen - 15);
+    }
+
+    return dest;
+}
+
+//
+// LZ_Compress
+// Greedy: each position takes the last earlier one with the same
+// four bytes, if it is near enough.
+//
+
+int LZ_Compress(const byte *src, int srclen, byte *dest)
+{
+    static int table[1 << HASHBITS];
+    byte *out;
+    unsigned int h;
+    int pos, anchor, ref, len;
+
+    out = dest;
+    anchor = 0;
+
+    if (srclen >= MFLIMIT + 1)
+    {
+        memset(table, 0xff, sizeof(table));
+
+        pos = 0;
+
+        while (pos < srclen - MFLIMIT)
+        {
+            h = HASH32(READ32(src + pos));
+            ref = table[h];
+            table[h] = pos;
+
+            if (ref < 0 || pos - ref > MAXDISTANCE
+             || READ32(src + ref) != READ32(src + pos))
+            {
+                ++pos;
+                continue;
+            }
+
+            len = MINMATCH;
+
+            while (pos + len < srclen - LASTLITERALS
+                && src[ref + len] == src[pos + len])
+            {
+                ++len;
+            }
+
+            out = LZ_PutSequence(out, src + anchor, pos - anchor,
+                                 pos - ref, len);
+            pos += len;
+            anchor = pos;
+        }
+    }
+
+    out = LZ_PutSequence(out, src + anchor, srclen - anchor, 0, 0);
+
+    return out - dest;
+}
+
+//
+// LZ_GetCount
+// Adds the extra bytes of a count of 15 to *count.
+//
+
+static boolean LZ_GetCount(const byte **src, const byte *end, int *count)
+{
+    int b;
+
+    do
+    {
+        if (*src >= end)
+        {
+            return false;
+        }
+
+        b = *(*src)++;
+        *count += b;
+    } while (b == 255);
+
+    return true;
+}
+
+//
+// LZ_Decompress
+//
+
+boolean LZ_Decompress(const byte *src, int srclen, byte *dest, int destlen)
+{
+    const byte *in, *inend;
+    byte *out, *outend;
+    const byte *match;
+    int token, len, distance;
+
+    in = src;
+    inend = src + srclen;
+    out = dest;
+    outend = dest + destlen;
+
+    for (;;)
+    {
+        if (in >= inend)
+        {
+            return false;
+        }
+
+        token = *in++;
+
+        len = token >> 4;
+
+        if (len == 15 && !LZ_GetCount(&in, inend, &len))
+        {
+            return false;
+        }
+
+        if (len > inend - in || len > outend - out)
+        {
+            return false;
+        }
+
+        memcpy(out, in, len);
+        out += len;
+        in += len;
+
+        if (in == inend)
+        {
+            return out == outend;
+        }
+
+        if (inend - in < 2)
+        {
+            return false;
+        }
+
+        distance = in[0] | (in[1] << 8);
+        in += 2;
+
+        if (distance == 0 || distance > out - dest)
+        {
+            return false;
+        }
+
+        len = (token & 15) + MINMATCH;
+
+        if (len == 15 + MINMATCH && !LZ_GetCount(&in, inend, &len))
+        {
+            return false;
+        }
+
+        if (len > outend - out)
+        {
+            return false;
+        }
+
+        match = out - distance;
+
+        if (distance >= len)
+        {
+            memcpy(out, match, len);
+            out += len;
+        }
+        else
+        {
+            // The match runs into the bytes it is making.
+
+            while (len-- > 0)
+            {
+                *out++ = *match++;
+            }
+        }
+    }
+}
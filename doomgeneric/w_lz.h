@@ -0,0 +1,69 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Packed WAD files: the file layout, and the LZ77 compression
+//	of their chunks.
+//
+
+#ifndef __W_LZ__
+#define __W_LZ__
+
+#include "doomtype.h"
+
+//
+// A packed WAD is a WAD cut into chunks, each compressed on its own,
+// so that any part of it can be read without unpacking the rest.
+// The packer starts a chunk at every lump, so that reading a lump
+// unpacks nothing else.  All integers are little endian.
+//
+//	lzwadinfo_t		header
+//	lzwadchunk_t[numchunks]	index, in order of position
+//	chunk data
+//
+
+#define LZWAD_ID	"LZWD"
+
+// No chunk unpacks to more than this.
+#define LZWAD_MAXCHUNK	65536
+
+typedef struct
+{
+    char	identification[4];	// LZWAD_ID
+    int		numchunks;
+    int		length;			// of the WAD as unpacked
+
+} PACKEDATTR lzwadinfo_t;
+
+typedef struct
+{
+    int		position;		// in the WAD as unpacked
+    int		filepos;		// of the packed data
+    int		size;			// packed; stored as is if the
+					//  chunk's unpacked size
+
+} PACKEDATTR lzwadchunk_t;
+
+// Worst case size of LZ_Compress output for srclen bytes.
+#define LZ_BOUND(srclen)	((srclen) + (srclen) / 255 + 16)
+
+// Compresses srclen bytes into dest, which must hold
+// LZ_BOUND(srclen) bytes.  Returns the compressed size.
+int LZ_Compress(const byte *src, int srclen, byte *dest);
+
+// Decompresses srclen bytes into exactly destlen bytes at dest.
+// Returns false if the data is damaged.
+boolean LZ_Decompress(const byte *src, int srclen, byte *dest, int destlen);
+
+#endif /* #ifndef __W_LZ__ */
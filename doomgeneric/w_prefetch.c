@@ -0,0 +1,276 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Reading lumps ahead of need, on a thread of its own.
+//
+//	The zone is not safe to use from two threads, so nothing read
+//	ahead goes into it.  Lumps are read through the WAD file's
+//	ReadShared into a scratch buffer and thrown away: what is kept
+//	is the system's copy, in its page cache or in the pages of a
+//	mapped WAD, and the main thread's own read of the lump later
+//	finds it there instead of waiting on the card or disk.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+#include "doomstat.h"
+#include "m_argv.h"
+#include "w_file.h"
+#include "w_prefetch.h"
+#include "w_wad.h"
+
+#define MAXPREFETCHJOBS 4
+
+// Lumps are read this much at a time.
+#define PREFETCHREAD 65536
+
+#ifdef HAVE_PTHREAD
+
+typedef struct
+{
+    prefetchfunc_t func;
+    int arg;
+} prefetchjob_t;
+
+static boolean prefetching = false;
+
+static pthread_mutex_t prefetch_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t prefetch_wake = PTHREAD_COND_INITIALIZER;
+
+// Jobs waiting, in a ring.  Guarded by prefetch_mutex.
+
+static prefetchjob_t prefetchjobs[MAXPREFETCHJOBS];
+static int prefetchhead;
+static int numprefetchjobs;
+
+#endif
+
+// The rest is used by the prefetch thread only.
+
+// A bit for each lump read by the job running.
+
+static byte *prefetchdone;
+
+static byte *prefetchbuffer;
+
+static int prefetchlumps;
+static int prefetchbytes;
+
+//
+// W_WarmLump
+//
+
+void W_WarmLump(int lump)
+{
+    lumpinfo_t *l;
+    unsigned int pos;
+    size_t len, count;
+
+    if (lump < 0 || lump >= numlumps
+     || (prefetchdone[lump >> 3] & (1 << (lump & 7))) != 0)
+    {
+        return;
+    }
+
+    prefetchdone[lump >> 3] |= 1 << (lump & 7);
+
+    l = &lumpinfo[lump];
+
+    for (pos = 0; pos < l->size; pos += len)
+    {
+        len = l->size - pos;
+
+        if (len > PREFETCHREAD)
+        {
+            len = PREFETCHREAD;
+        }
+
+        count = W_ReadShared(l->wad_file, l->position + pos,
+                             prefetchbuffer, len);
+        prefetchbytes += count;
+
+        if (count < len)
+        {
+            break;
+        }
+    }
+
+    ++prefetchlumps;
+}
+
+//
+// W_ReadLumpShared
+//
+
+void *W_ReadLumpShared(int lump)
+{
+    lumpinfo_t *l;
+    byte *result;
+
+    if (lump < 0 || lump >= numlumps)
+    {
+        return NULL;
+    }
+
+    l = &lumpinfo[lump];
+    result = malloc(l->size + 1);
+
+    if (result == NULL)
+    {
+        return NULL;
+    }
+
+    if (W_ReadShared(l->wad_file, l->position, result, l->size) < l->size)
+    {
+        free(result);
+        return NULL;
+    }
+
+    if ((prefetchdone[lump >> 3] & (1 << (lump & 7))) == 0)
+    {
+        prefetchdone[lump >> 3] |= 1 << (lump & 7);
+        prefetchbytes += l->size;
+        ++prefetchlumps;
+    }
+
+    return result;
+}
+
+#ifdef HAVE_PTHREAD
+
+//
+// W_PrefetchThread
+// Runs the jobs as they are queued.
+//
+
+static void *W_PrefetchThread(void *arg)
+{
+    prefetchjob_t job;
+
+    for (;;)
+    {
+        pthread_mutex_lock(&prefetch_mutex);
+
+        while (numprefetchjobs == 0)
+        {
+            pthread_cond_wait(&prefetch_wake, &prefetch_mutex);
+        }
+
+        job = prefetchjobs[prefetchhead];
+        prefetchhead = (prefetchhead + 1) % MAXPREFETCHJOBS;
+        --numprefetchjobs;
+
+        pthread_mutex_unlock(&prefetch_mutex);
+
+        memset(prefetchdone, 0, (numlumps + 7) / 8);
+        prefetchlumps = 0;
+        prefetchbytes = 0;
+
+        job.func(job.arg);
+
+        if (devparm)
+        {
+            printf("W_PrefetchThread: read %i lumps, %i KB ahead\n",
+                   prefetchlumps, prefetchbytes / 1024);
+        }
+    }
+
+    return NULL;
+}
+
+#endif
+
+//
+// W_StartPrefetch
+//
+
+boolean W_StartPrefetch(prefetchfunc_t func, int arg)
+{
+#ifdef HAVE_PTHREAD
+    boolean result;
+
+    if (!prefetching)
+    {
+        return false;
+    }
+
+    pthread_mutex_lock(&prefetch_mutex);
+
+    result = numprefetchjobs < MAXPREFETCHJOBS;
+
+    if (result)
+    {
+        prefetchjobs[(prefetchhead + numprefetchjobs) % MAXPREFETCHJOBS].func
+            = func;
+        prefetchjobs[(prefetchhead + numprefetchjobs) % MAXPREFETCHJOBS].arg
+            = arg;
+        ++numprefetchjobs;
+        pthread_cond_signal(&prefetch_wake);
+    }
+
+    pthread_mutex_unlock(&prefetch_mutex);
+
+    return result;
+#else
+    return false;
+#endif
+}
+
+//
+// W_InitPrefetch
+//
+
+void W_InitPrefetch(void)
+{
+#ifdef HAVE_PTHREAD
+    pthread_t thread;
+#endif
+
+    //!
+    // @category obscure
+    //
+    // Read the next level's lumps on a thread of their own while the
+    // intermission screen is up.
+    //
+
+    if (!M_ParmExists("-prefetch"))
+    {
+        return;
+    }
+
+#ifdef HAVE_PTHREAD
+    prefetchdone = malloc((numlumps + 7) / 8);
+    prefetchbuffer = malloc(PREFETCHREAD);
+
+    if (prefetchdone == NULL || prefetchbuffer == NULL
+     || pthread_create(&thread, NULL, W_PrefetchThread, NULL) != 0)
+    {
+        printf("W_InitPrefetch: failed to start the prefetch thread\n");
+        return;
+    }
+
+    pthread_detach(thread);
+    prefetching = true;
+#else
+    printf("W_InitPrefetch: built without thread support, "
+           "not prefetching\n");
+#endif
+}
@@ -0,0 +1,50 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Reading lumps ahead of need, on a thread of its own.
+//
+
+#ifndef __W_PREFETCH__
+#define __W_PREFETCH__
+
+#include "doomtype.h"
+
+// A prefetch job.  Runs on the prefetch thread, so it may use
+// only what does not change once the game has started: the lump
+// directory and the functions below, the texture and sprite
+// tables, mobjinfo.  Never the zone.
+
+typedef void (*prefetchfunc_t)(int arg);
+
+// Starts the prefetch thread if -prefetch was given.
+
+void W_InitPrefetch(void);
+
+// Queues func(arg) to run on the prefetch thread.  Returns false,
+// and drops the job, if there is no thread or the queue is full.
+
+boolean W_StartPrefetch(prefetchfunc_t func, int arg);
+
+// Reads a lump so that the system has it in memory when the game
+// reads it.  A lump already read by the same job is skipped.
+
+void W_WarmLump(int lump);
+
+// Reads a lump into a buffer from malloc(), which the caller frees.
+// Returns NULL if it cannot.
+
+void *W_ReadLumpShared(int lump);
+
+#endif /* #ifndef __W_PREFETCH__ */
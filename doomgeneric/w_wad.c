@@ -61,9 +61,31 @@ typedef struct
 lumpinfo_t *lumpinfo;		
 unsigned int numlumps = 0;
 
-// Hash table for fast lookups
+// Hash table for fast lookups: open addressed, with a power of two
+// slots, each holding a lump number or -1 if empty.  Each lump's
+// name, packed by W_LumpNameKey, is in lumpkeys[].
 
-static lumpinfo_t **lumphash;
+static int *lumphash;
+static unsigned int lumphashmask;
+static uint64_t *lumpkeys;
+
+// The lump each block returned by W_CacheLumpNum holds, by its
+// address, so that W_LumpForData need not search the directory.
+// Open addressed like lumphash, with a NULL key for an empty slot.
+// A block that is freed stays in until the table is rebuilt, so a
+// match is checked with W_IsLumpData.
+
+static void **lumpdatakeys;
+static int *lumpdatalumps;
+static unsigned int lumpdatamask;
+static unsigned int numlumpdata;
+
+// W_CacheLumpNum calls that found the lump in memory, calls that
+// read it, and reads of a lump that had been read before.
+
+int lumpcachehits;
+int lumpcachemisses;
+int lumpcacherereads;
 
 // Hash function used for lump names.
 
@@ -83,6 +105,112 @@ unsigned int W_LumpNameHash(const char *s)
     return result;
 }
 
+// A lump name, upper cased and packed into 64 bits in the same way
+// on any machine, so that names compare in one go.  Names shorter
+// than 8 are padded with zeros, as in the WAD directory.
+
+static uint64_t W_LumpNameKey(const char *s)
+{
+    uint64_t result = 0;
+    unsigned int i;
+    unsigned char c;
+
+    for (i=0; i < 8 && s[i] != '\0'; ++i)
+    {
+        c = s[i];
+
+        if (c >= 'a' && c <= 'z')
+        {
+            c -= 'a' - 'A';
+        }
+
+        result |= (uint64_t) c << (i * 8);
+    }
+
+    return result;
+}
+
+// The slot to start looking for a packed name at.
+
+static unsigned int W_LumpKeySlot(uint64_t key)
+{
+    return (unsigned int) ((key * 0x9e3779b97f4a7c15ULL) >> 32)
+         & lumphashmask;
+}
+
+// The slot to start looking for a lump's data at.
+
+static unsigned int W_LumpDataSlot(void *data)
+{
+    return (unsigned int) (((uint64_t) (uintptr_t) data
+                            * 0x9e3779b97f4a7c15ULL) >> 32)
+         & lumpdatamask;
+}
+
+// Puts data in the table as the lump's, in place of any lump that
+// was at that address before.
+
+static void W_InsertLumpData(int lumpnum, void *data)
+{
+    unsigned int slot;
+
+    for (slot = W_LumpDataSlot(data); lumpdatakeys[slot] != NULL;
+         slot = (slot + 1) & lumpdatamask)
+    {
+        if (lumpdatakeys[slot] == data)
+        {
+            lumpdatalumps[slot] = lumpnum;
+            return;
+        }
+    }
+
+    lumpdatakeys[slot] = data;
+    lumpdatalumps[slot] = lumpnum;
+    ++numlumpdata;
+}
+
+// Makes sure there is a free slot for one more address.  When the
+// table is three quarters full, it is made again from the lumps
+// that are in memory now, at twice as many slots as lumps.  This
+// allocates, so it is called before a lump is read into the zone,
+// never after, when the new block could be purged.
+
+static void W_MakeRoomForLumpData(void)
+{
+    unsigned int size;
+    unsigned int i;
+
+    if (lumpdatakeys == NULL || (numlumpdata + 1) * 4 > (lumpdatamask + 1) * 3)
+    {
+        if (lumpdatakeys != NULL)
+        {
+            Z_Free(lumpdatakeys);
+            Z_Free(lumpdatalumps);
+        }
+
+        for (size = 16; size < numlumps * 2; size <<= 1);
+
+        lumpdatakeys = Z_Malloc(sizeof(void *) * size, PU_STATIC, NULL);
+        lumpdatalumps = Z_Malloc(sizeof(int) * size, PU_STATIC, NULL);
+        lumpdatamask = size - 1;
+        numlumpdata = 0;
+        memset(lumpdatakeys, 0, sizeof(void *) * size);
+
+        for (i=0; i<numlumps; ++i)
+        {
+            if (lumpinfo[i].wad_file->mapped != NULL)
+            {
+                W_InsertLumpData(i, lumpinfo[i].wad_file->mapped
+                                  + lumpinfo[i].position);
+            }
+            else if (lumpinfo[i].cache != NULL)
+            {
+                W_InsertLumpData(i, lumpinfo[i].cache);
+            }
+        }
+    }
+}
+
 // Increase the size of the lumpinfo[] array to the specified size.
 static void ExtendLumpInfo(int newnumlumps)
 {
@@ -107,14 +235,6 @@ static void ExtendLumpInfo(int newnumlumps)
         {
             Z_ChangeUser(newlumpinfo[i].cache, &newlumpinfo[i].cache);
         }
-
-        // We shouldn't be generating a hash table until after all WADs have
-        // been loaded, but just in case...
-        if (lumpinfo[i].next != NULL)
-        {
-            int nextlumpnum = lumpinfo[i].next - lumpinfo;
-            newlumpinfo[i].next = &newlumpinfo[nextlumpnum];
-        }
     }
 
     // All done.
@@ -230,6 +350,7 @@ wad_file_t *W_AddFile (char *filename)
     if (lumphash != NULL)
     {
         Z_Free(lumphash);
+        Z_Free(lumpkeys);
         lumphash = NULL;
     }
 
@@ -255,24 +376,24 @@ int W_NumLumps (void)
 
 int W_CheckNumForName (char* name)
 {
-    lumpinfo_t *lump_p;
+    uint64_t key;
+    unsigned int slot;
     int i;
 
+    key = W_LumpNameKey(name);
+
     // Do we have a hash table yet?
 
     if (lumphash != NULL)
     {
-        int hash;
-        
         // We do! Excellent.
 
-        hash = W_LumpNameHash(name) % numlumps;
-        
-        for (lump_p = lumphash[hash]; lump_p != NULL; lump_p = lump_p->next)
+        for (slot = W_LumpKeySlot(key); lumphash[slot] >= 0;
+             slot = (slot + 1) & lumphashmask)
         {
-            if (!strncasecmp(lump_p->name, name, 8))
+            if (lumpkeys[lumphash[slot]] == key)
             {
-                return lump_p - lumpinfo;
+                return lumphash[slot];
             }
         }
     } 
@@ -284,7 +405,7 @@ int W_CheckNumForName (char* name)
 
         for (i=numlumps-1; i >= 0; --i)
         {
-            if (!strncasecmp(lumpinfo[i].name, name, 8))
+            if (W_LumpNameKey(lumpinfo[i].name) == key)
             {
                 return i;
             }
@@ -401,21 +522,37 @@ void *W_CacheLumpNum(int lumpnum, int tag)
         // Memory mapped file, return from the mmapped region.
 
         result = lump->wad_file->mapped + lump->position;
+        W_MakeRoomForLumpData();
+        W_InsertLumpData(lumpnum, result);
+        ++lumpcachehits;
     }
     else if (lump->cache != NULL)
     {
-        // Already cached, so just switch the zone tag.
+        // Already cached, so just switch the zone tag, and mark
+        // it used so that it is purged after older lumps.
 
         result = lump->cache;
         Z_ChangeTag(lump->cache, tag);
+        Z_Touch(lump->cache);
+        ++lumpcachehits;
     }
     else
     {
         // Not yet loaded, so load it now
 
+        W_MakeRoomForLumpData();
+
         lump->cache = Z_Malloc(W_LumpLength(lumpnum), tag, &lump->cache);
 	W_ReadLump (lumpnum, lump->cache);
         result = lump->cache;
+        W_InsertLumpData(lumpnum, result);
+        ++lumpcachemisses;
+
+        if (lump->cachereads++ > 0)
+        {
+            // It was purged since it was last read.
+            ++lumpcacherereads;
+        }
     }
 	
     return result;
@@ -431,6 +568,61 @@ void *W_CacheLumpName(char *name, int tag)
     return W_CacheLumpNum(W_GetNumForName(name), tag);
 }
 
+
+//
+// W_IsLumpData
+// Returns true if data is where the lump is cached or mapped.
+//
+boolean W_IsLumpData(int lumpnum, void *data)
+{
+    lumpinfo_t *lump;
+
+    if ((unsigned)lumpnum >= numlumps)
+    {
+        return false;
+    }
+
+    lump = &lumpinfo[lumpnum];
+
+    if (lump->wad_file->mapped != NULL)
+    {
+        return lump->wad_file->mapped + lump->position == data;
+    }
+
+    return lump->cache == data && data != NULL;
+}
+
+//
+// W_LumpForData
+// Returns the lump W_CacheLumpNum returned data for, or -1 if there
+// is none or the lump is no longer there.
+//
+int W_LumpForData(void *data)
+{
+    unsigned int slot;
+
+    if (lumpdatakeys == NULL || data == NULL)
+    {
+        return -1;
+    }
+
+    for (slot = W_LumpDataSlot(data); lumpdatakeys[slot] != NULL;
+         slot = (slot + 1) & lumpdatamask)
+    {
+        if (lumpdatakeys[slot] == data)
+        {
+            if (W_IsLumpData(lumpdatalumps[slot], data))
+            {
+                return lumpdatalumps[slot];
+            }
+
+            return -1;
+        }
+    }
+
+    return -1;
+}
+
 // 
 // Release a lump back to the cache, so that it can be reused later 
 // without having to read from disk again, or alternatively, discarded
@@ -538,6 +730,8 @@ void W_Profile (void)
 
 void W_GenerateHashTable(void)
 {
+    unsigned int size;
+    unsigned int slot;
     unsigned int i;
 
     // Free the old hash table, if there is one
@@ -545,24 +739,41 @@ void W_GenerateHashTable(void)
     if (lumphash != NULL)
     {
         Z_Free(lumphash);
+        Z_Free(lumpkeys);
+        lumphash = NULL;
     }
 
     // Generate hash table
     if (numlumps > 0)
     {
-        lumphash = Z_Malloc(sizeof(lumpinfo_t *) * numlumps, PU_STATIC, NULL);
-        memset(lumphash, 0, sizeof(lumpinfo_t *) * numlumps);
+        // At most half full, so that misses end soon.
+
+        for (size = 16; size < numlumps * 2; size <<= 1);
+
+        lumphash = Z_Malloc(sizeof(int) * size, PU_STATIC, NULL);
+        lumphashmask = size - 1;
+        memset(lumphash, 0xff, sizeof(int) * size);
+
+        lumpkeys = Z_Malloc(sizeof(uint64_t) * numlumps, PU_STATIC, NULL);
+
+        // Lumps go in in order, and one with the name of a lump
+        // already in takes its slot, so the last one loaded wins,
+        // as with the linear search.
 
         for (i=0; i<numlumps; ++i)
         {
-            unsigned int hash;
+            lumpkeys[i] = W_LumpNameKey(lumpinfo[i].name);
 
-            hash = W_LumpNameHash(lumpinfo[i].name) % numlumps;
-
-            // Hook into the hash table
+            for (slot = W_LumpKeySlot(lumpkeys[i]); lumphash[slot] >= 0;
+                 slot = (slot + 1) & lumphashmask)
+            {
+                if (lumpkeys[lumphash[slot]] == lumpkeys[i])
+                {
+                    break;
+                }
+            }
 
-            lumpinfo[i].next = lumphash[hash];
-            lumphash[hash] = &lumpinfo[i];
+            lumphash[slot] = i;
         }
     }
 
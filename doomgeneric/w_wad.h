@@ -45,16 +45,17 @@ struct lumpinfo_s
     int		position;
     int		size;
     void       *cache;
-
-    // Used for hash table lookups
-
-    lumpinfo_t *next;
+    int		cachereads;	// times read into the cache
 };
 
 
 extern lumpinfo_t *lumpinfo;
 extern unsigned int numlumps;
 
+extern int lumpcachehits;
+extern int lumpcachemisses;
+extern int lumpcacherereads;
+
 wad_file_t *W_AddFile (char *filename);
 
 int	W_CheckNumForName (char* name);
@@ -66,6 +67,9 @@ void    W_ReadLump (unsigned int lump, void *dest);
 void*	W_CacheLumpNum (int lump, int tag);
 void*	W_CacheLumpName (char* name, int tag);
 
+boolean	W_IsLumpData (int lump, void* data);
+int	W_LumpForData (void* data);
+
 void    W_GenerateHashTable(void);
 
 extern unsigned int W_LumpNameHash(const char *s);
@@ -0,0 +1,287 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	wadpack: packs a WAD into the format read by w_file_lz.c.
+//	Built on the host with "make wadpack":
+//
+//	    wadpack doom.wad doom.lzw
+//
+//	The packed file can keep the WAD's own name, as the game
+//	knows it by its contents.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "w_lz.h"
+
+typedef struct
+{
+    char identification[4];
+    int numlumps;
+    int infotableofs;
+} PACKEDATTR wadinfo_t;
+
+typedef struct
+{
+    int filepos;
+    int size;
+    char name[8];
+} PACKEDATTR filelump_t;
+
+static int ReadInt(const void *p)
+{
+    const byte *b = p;
+
+    return b[0] | (b[1] << 8) | (b[2] << 16) | ((unsigned int) b[3] << 24);
+}
+
+static void WriteInt(void *p, int value)
+{
+    byte *b = p;
+
+    b[0] = value & 0xff;
+    b[1] = (value >> 8) & 0xff;
+    b[2] = (value >> 16) & 0xff;
+    b[3] = (value >> 24) & 0xff;
+}
+
+static int CompareInts(const void *a, const void *b)
+{
+    return *(const int *) a - *(const int *) b;
+}
+
+static void Fail(const char *msg, const char *arg)
+{
+    fprintf(stderr, "wadpack: %s %s\n", msg, arg);
+    exit(1);
+}
+
+//
+// ReadWholeFile
+//
+
+static byte *ReadWholeFile(const char *path, int *length)
+{
+    FILE *f;
+    byte *data;
+    long len;
+
+    f = fopen(path, "rb");
+
+    if (f == NULL)
+    {
+        Fail("couldn't open", path);
+    }
+
+    fseek(f, 0, SEEK_END);
+    len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    data = malloc(len + 1);
+
+    if (data == NULL || fread(data, 1, len, f) != (size_t) len)
+    {
+        Fail("couldn't read", path);
+    }
+
+    fclose(f);
+    *length = len;
+
+    return data;
+}
+
+//
+// ChunkBounds
+// Returns where chunks start: at the header, the directory and
+// the start and end of every lump, with long runs cut up.
+//
+
+static int *ChunkBounds(const char *path, byte *wad, int length,
+                        int *numbounds)
+{
+    wadinfo_t *header;
+    filelump_t *lump;
+    int numlumps, infotableofs;
+    int *bounds, *result;
+    int num, i, n, pos;
+
+    if (length < (int) sizeof(wadinfo_t)
+     || (strncmp((char *) wad, "IWAD", 4) != 0
+      && strncmp((char *) wad, "PWAD", 4) != 0))
+    {
+        Fail("not a WAD file:", path);
+    }
+
+    header = (wadinfo_t *) wad;
+    numlumps = ReadInt(&header->numlumps);
+    infotableofs = ReadInt(&header->infotableofs);
+
+    if (numlumps < 0 || infotableofs < 0
+     || infotableofs + numlumps * (int) sizeof(filelump_t) > length)
+    {
+        Fail("bad directory in", path);
+    }
+
+    bounds = malloc((numlumps * 2 + 4) * sizeof(int));
+    num = 0;
+
+    bounds[num++] = 0;
+    bounds[num++] = sizeof(wadinfo_t);
+    bounds[num++] = infotableofs;
+    bounds[num++] = infotableofs + numlumps * sizeof(filelump_t);
+
+    lump = (filelump_t *) (wad + infotableofs);
+
+    for (i = 0; i < numlumps; ++i, ++lump)
+    {
+        pos = ReadInt(&lump->filepos);
+
+        if (pos >= 0 && pos <= length)
+        {
+            bounds[num++] = pos;
+        }
+
+        pos += ReadInt(&lump->size);
+
+        if (pos >= 0 && pos <= length)
+        {
+            bounds[num++] = pos;
+        }
+    }
+
+    qsort(bounds, num, sizeof(int), CompareInts);
+
+    // Drop repeats and the end of the file; cut long chunks.
+
+    result = malloc((num + length / LZWAD_MAXCHUNK + 1) * sizeof(int));
+    n = 0;
+
+    for (i = 0; i < num; ++i)
+    {
+        if (bounds[i] >= length || (n > 0 && result[n - 1] == bounds[i]))
+        {
+            continue;
+        }
+
+        while (n > 0 && bounds[i] - result[n - 1] > LZWAD_MAXCHUNK)
+        {
+            result[n] = result[n - 1] + LZWAD_MAXCHUNK;
+            ++n;
+        }
+
+        result[n++] = bounds[i];
+    }
+
+    while (n > 0 && length - result[n - 1] > LZWAD_MAXCHUNK)
+    {
+        result[n] = result[n - 1] + LZWAD_MAXCHUNK;
+        ++n;
+    }
+
+    free(bounds);
+    *numbounds = n;
+
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    lzwadinfo_t header;
+    lzwadchunk_t *index;
+    byte *wad, *packed, *check;
+    int *bounds;
+    int numchunks, length, chunklen, size, filepos;
+    int i;
+    FILE *out;
+
+    if (argc != 3)
+    {
+        fprintf(stderr, "usage: wadpack <input.wad> <output>\n");
+        return 1;
+    }
+
+    wad = ReadWholeFile(argv[1], &length);
+    bounds = ChunkBounds(argv[1], wad, length, &numchunks);
+
+    index = malloc(numchunks * sizeof(lzwadchunk_t));
+    packed = malloc(LZ_BOUND(LZWAD_MAXCHUNK));
+    check = malloc(LZWAD_MAXCHUNK);
+
+    out = fopen(argv[2], "wb");
+
+    if (out == NULL)
+    {
+        Fail("couldn't open", argv[2]);
+    }
+
+    memcpy(header.identification, LZWAD_ID, 4);
+    WriteInt(&header.numchunks, numchunks);
+    WriteInt(&header.length, length);
+
+    filepos = sizeof(header) + numchunks * sizeof(lzwadchunk_t);
+
+    // The index goes in once the chunk sizes are known.
+
+    fseek(out, filepos, SEEK_SET);
+
+    for (i = 0; i < numchunks; ++i)
+    {
+        chunklen = (i + 1 < numchunks ? bounds[i + 1] : length) - bounds[i];
+        size = LZ_Compress(wad + bounds[i], chunklen, packed);
+
+        // Store what does not get smaller.  Every packed chunk is
+        // unpacked again here, so a bad one is never written.
+
+        if (size >= chunklen)
+        {
+            size = chunklen;
+            memcpy(packed, wad + bounds[i], chunklen);
+        }
+        else if (!LZ_Decompress(packed, size, check, chunklen)
+              || memcmp(check, wad + bounds[i], chunklen) != 0)
+        {
+            Fail("chunk did not unpack to its data in", argv[1]);
+        }
+
+        WriteInt(&index[i].position, bounds[i]);
+        WriteInt(&index[i].filepos, filepos);
+        WriteInt(&index[i].size, size);
+
+        if (fwrite(packed, 1, size, out) != (size_t) size)
+        {
+            Fail("couldn't write", argv[2]);
+        }
+
+        filepos += size;
+    }
+
+    fseek(out, 0, SEEK_SET);
+
+    if (fwrite(&header, sizeof(header), 1, out) != 1
+     || fwrite(index, sizeof(lzwadchunk_t), numchunks, out)
+            != (size_t) numchunks
+     || fclose(out) != 0)
+    {
+        Fail("couldn't write", argv[2]);
+    }
+
+    printf("%s: %i bytes in %i chunks packed to %i bytes (%i%%)\n",
+           argv[1], length, numchunks, filepos,
+           length > 0 ? (int) ((long long) filepos * 100 / length) : 100);
+
+    return 0;
+}
@@ -0,0 +1,720 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Zone Memory Allocation with free lists segregated by size.
+//	Built instead of z_zone.c when ZONE_SEGFIT is defined.
+//
+
+
+#include <string.h>
+
+#include "z_zone.h"
+#include "z_trace.h"
+#include "i_system.h"
+#include "doomtype.h"
+
+#ifdef ZONE_SEGFIT
+
+
+//
+// ZONE MEMORY ALLOCATION
+//
+// The blocks still tile the zone from end to end.  But instead of
+// a rover walking over all of them, each free block is on the list
+// of its size class, and each block in use is on the list of its
+// tag.
+//
+// Each block keeps the size of the one before it, so a freed block
+// is merged with its free neighbours at once, without a walk.
+// There are never two contiguous free blocks.
+//
+// Z_Malloc takes a free block from the lowest class that is sure
+// to be big enough, found from bitmaps of the lists in use.  Only
+// when there is none are purgable blocks freed, the block used
+// longest ago first, until one merges into a block that is big
+// enough.
+//
+// Large blocks are taken from the end of a free block rather than
+// its start, so that they gather away from the small ones.
+//
+
+#define MEM_ALIGN	sizeof(void *)
+#define ZONEID		0x1d4a11
+
+typedef struct memblock_s
+{
+    int			size;	// including the header
+    int			prevsize; // of the block before, 0 if first
+    void**		user;
+    int			tag;	// PU_FREE if this is free
+    int			id;	// should be ZONEID
+
+    // On the free list of its size class, or the list of its tag.
+    struct memblock_s*	next;
+    struct memblock_s*	prev;
+} memblock_t;
+
+// A size class for each power of two, split in SL_COUNT steps.
+#define FL_COUNT	32
+#define SL_BITS		3
+#define SL_COUNT	(1 << SL_BITS)
+
+// Smallest block kept: a header and a useful fragment.
+#define MINFRAGMENT	64
+#define MINBLOCK	((int) sizeof(memblock_t) + MINFRAGMENT)
+
+// Blocks at least this big are large blocks.
+#define LARGEBLOCK	(64*1024)
+
+typedef struct
+{
+    // total bytes malloced, including header
+    int		size;
+
+    // The first block, and a block in use with no room after the last.
+    memblock_t*	first;
+    memblock_t*	end;
+
+    // Free blocks by size class, and bitmaps of the lists in use.
+    memblock_t*	freelists[FL_COUNT][SL_COUNT];
+    unsigned int	flbitmap;
+    unsigned int	slbitmap[FL_COUNT];
+
+    // Blocks in use by tag, each in the order the blocks got it or
+    // were last used.
+    memblock_t	taglists[PU_NUM_TAGS];
+
+} memzone_t;
+
+
+
+memzone_t*	mainzone;
+
+
+#define NEXTBLOCK(block) \
+    ((memblock_t *) ((byte *) (block) + (block)->size))
+#define PREVBLOCK(block) \
+    ((memblock_t *) ((byte *) (block) - (block)->prevsize))
+
+static const int debruijnbits[32] =
+{
+    0, 1, 28, 2, 29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4, 8,
+    31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6, 11, 5, 10, 9
+};
+
+// Lowest bit set in a non-zero bitmap.
+#define LOWESTBIT(bits) \
+    debruijnbits[(((bits) & -(bits)) * 0x077cb531u) >> 27]
+
+
+//
+// Z_SizeClass
+// Finds the class of a free block of size bytes.
+//
+static void Z_SizeClass (unsigned int size, int* fl, int* sl)
+{
+    unsigned int	bits;
+    int			bit;
+
+    bits = size;
+    bit = 0;
+
+    if (bits >= 1u << 16) { bits >>= 16; bit += 16; }
+    if (bits >= 1u << 8) { bits >>= 8; bit += 8; }
+    if (bits >= 1u << 4) { bits >>= 4; bit += 4; }
+    if (bits >= 1u << 2) { bits >>= 2; bit += 2; }
+    if (bits >= 1u << 1) { bit += 1; }
+
+    *fl = bit;
+    *sl = (size >> (bit - SL_BITS)) & (SL_COUNT - 1);
+}
+
+
+//
+// Z_InsertFree
+//
+static void Z_InsertFree (memblock_t* block)
+{
+    memblock_t**	list;
+    int			fl;
+    int			sl;
+
+    Z_SizeClass (block->size, &fl, &sl);
+
+    list = &mainzone->freelists[fl][sl];
+
+    block->prev = NULL;
+    block->next = *list;
+
+    if (*list != NULL)
+	(*list)->prev = block;
+
+    *list = block;
+
+    mainzone->flbitmap |= 1u << fl;
+    mainzone->slbitmap[fl] |= 1u << sl;
+}
+
+
+//
+// Z_RemoveFree
+//
+static void Z_RemoveFree (memblock_t* block)
+{
+    int		fl;
+    int		sl;
+
+    if (block->next != NULL)
+	block->next->prev = block->prev;
+
+    if (block->prev != NULL)
+    {
+	block->prev->next = block->next;
+	return;
+    }
+
+    Z_SizeClass (block->size, &fl, &sl);
+
+    mainzone->freelists[fl][sl] = block->next;
+
+    if (block->next == NULL)
+    {
+	mainzone->slbitmap[fl] &= ~(1u << sl);
+
+	if (mainzone->slbitmap[fl] == 0)
+	    mainzone->flbitmap &= ~(1u << fl);
+    }
+}
+
+
+//
+// Z_FindFree
+// Returns a free block of at least size bytes, or NULL.
+//
+static memblock_t* Z_FindFree (int size)
+{
+    unsigned int	bits;
+    int			fl;
+    int			sl;
+
+    Z_SizeClass (size, &fl, &sl);
+
+    // Unless size starts its class, look in the classes after it,
+    // where every block is big enough.
+    if (size & ((1 << (fl - SL_BITS)) - 1))
+    {
+	if (++sl == SL_COUNT)
+	{
+	    sl = 0;
+	    fl++;
+	}
+    }
+
+    if (fl >= FL_COUNT)
+	return NULL;
+
+    bits = mainzone->slbitmap[fl] & (~0u << sl);
+
+    if (bits == 0)
+    {
+	if (fl + 1 >= FL_COUNT)
+	    return NULL;
+
+	bits = mainzone->flbitmap & (~0u << (fl + 1));
+
+	if (bits == 0)
+	    return NULL;
+
+	fl = LOWESTBIT(bits);
+	bits = mainzone->slbitmap[fl];
+    }
+
+    sl = LOWESTBIT(bits);
+
+    return mainzone->freelists[fl][sl];
+}
+
+
+//
+// Z_LinkTag
+// Puts a block at the end of the list of its new tag.
+//
+static void Z_LinkTag (memblock_t* block, int tag)
+{
+    memblock_t*		list;
+
+    if (tag < PU_STATIC || tag >= PU_NUM_TAGS || tag == PU_FREE)
+	I_Error ("Z_LinkTag: bad tag %i", tag);
+
+    list = &mainzone->taglists[tag];
+
+    block->tag = tag;
+    block->next = list;
+    block->prev = list->prev;
+    list->prev->next = block;
+    list->prev = block;
+}
+
+
+//
+// Z_UnlinkTag
+//
+static void Z_UnlinkTag (memblock_t* block)
+{
+    block->prev->next = block->next;
+    block->next->prev = block->prev;
+}
+
+
+//
+// Z_Init
+//
+void Z_Init (void)
+{
+    memblock_t*	block;
+    int		size;
+    int		i;
+
+    mainzone = (memzone_t *)I_ZoneBase (&size);
+    memset (mainzone, 0, sizeof(memzone_t));
+    mainzone->size = size;
+
+    for (i=0 ; i<PU_NUM_TAGS ; i++)
+    {
+	mainzone->taglists[i].next = &mainzone->taglists[i];
+	mainzone->taglists[i].prev = &mainzone->taglists[i];
+    }
+
+    // set the entire zone to one free block
+    block = (memblock_t *) ((byte *) mainzone
+			    + ((sizeof(memzone_t) + MEM_ALIGN - 1)
+			       & ~(MEM_ALIGN - 1)));
+
+    block->size = ((byte *) mainzone + size - (byte *) block
+		   - sizeof(memblock_t)) & ~(MEM_ALIGN - 1);
+    block->prevsize = 0;
+    block->user = NULL;
+    block->tag = PU_FREE;
+    block->id = 0;
+
+    mainzone->first = block;
+    mainzone->end = NEXTBLOCK(block);
+
+    mainzone->end->size = sizeof(memblock_t);
+    mainzone->end->prevsize = block->size;
+    mainzone->end->user = NULL;
+    mainzone->end->tag = PU_STATIC;
+    mainzone->end->id = 0;
+
+    Z_InsertFree (block);
+}
+
+
+//
+// Z_FreeBlock
+// Frees a block for Z_Free, or to purge it or free its tag, and
+// returns the free block it was merged into.
+//
+static memblock_t* Z_FreeBlock (memblock_t* block)
+{
+    memblock_t*		other;
+
+    if (block->user != NULL)
+    {
+	// clear the user's mark
+	*block->user = 0;
+    }
+
+    Z_UnlinkTag (block);
+
+    // mark as free
+    block->tag = PU_FREE;
+    block->user = NULL;
+    block->id = 0;
+
+    if (block->prevsize != 0)
+    {
+	other = PREVBLOCK(block);
+
+	if (other->tag == PU_FREE)
+	{
+	    // merge with previous free block
+	    Z_RemoveFree (other);
+	    other->size += block->size;
+	    block = other;
+	}
+    }
+
+    other = NEXTBLOCK(block);
+
+    if (other->tag == PU_FREE)
+    {
+	// merge the next free block onto the end
+	Z_RemoveFree (other);
+	block->size += other->size;
+	other = NEXTBLOCK(block);
+    }
+
+    other->prevsize = block->size;
+
+    Z_InsertFree (block);
+
+    return block;
+}
+
+
+//
+// Z_Free
+//
+void Z_Free (void* ptr)
+{
+    memblock_t*		block;
+
+    block = (memblock_t *) ( (byte *)ptr - sizeof(memblock_t));
+
+    if (block->id != ZONEID)
+	I_Error ("Z_Free: freed a pointer without ZONEID");
+
+    if (zonetrace)
+	Z_TraceFree (ptr);
+
+    Z_FreeBlock (block);
+}
+
+
+
+//
+// Z_Malloc
+// You can pass a NULL user if the tag is < PU_PURGELEVEL.
+//
+void*
+Z_Malloc
+( int		size,
+  int		tag,
+  void*		user )
+{
+    memblock_t*	block;
+    memblock_t*	newblock;
+    memblock_t*	list;
+    int		request;
+    int		extra;
+    int		purgetag;
+    void*	result;
+
+    if (user == NULL && tag >= PU_PURGELEVEL)
+	I_Error ("Z_Malloc: an owner is required for purgable blocks");
+
+    request = size;
+    size = (size + MEM_ALIGN - 1) & ~(MEM_ALIGN - 1);
+
+    // account for size of block header
+    size += sizeof(memblock_t);
+
+    if (size < MINBLOCK)
+	size = MINBLOCK;
+
+    block = Z_FindFree (size);
+
+    // Purge blocks until one merges into a block big enough,
+    // starting with those that have been purgable longest.
+    while (block == NULL)
+    {
+	list = NULL;
+
+	for (purgetag = PU_NUM_TAGS - 1 ; purgetag >= PU_PURGELEVEL ;
+	     purgetag--)
+	{
+	    if (mainzone->taglists[purgetag].next
+	     != &mainzone->taglists[purgetag])
+	    {
+		list = &mainzone->taglists[purgetag];
+		break;
+	    }
+	}
+
+	if (list == NULL)
+	    I_Error ("Z_Malloc: failed on allocation of %i bytes", size);
+
+	block = Z_FreeBlock (list->next);
+
+	if (block->size < size)
+	    block = NULL;
+    }
+
+    Z_RemoveFree (block);
+
+    extra = block->size - size;
+
+    if (extra >= MINBLOCK)
+    {
+	if (size >= LARGEBLOCK)
+	{
+	    // the free fragment stays in front of a large block
+	    newblock = block;
+	    newblock->size = extra;
+
+	    block = NEXTBLOCK(newblock);
+	    block->size = size;
+	    block->prevsize = extra;
+	}
+	else
+	{
+	    // there will be a free fragment after the allocated block
+	    newblock = (memblock_t *) ((byte *)block + size);
+	    newblock->size = extra;
+	    newblock->prevsize = size;
+	    newblock->tag = PU_FREE;
+	    newblock->user = NULL;
+	    newblock->id = 0;
+
+	    block->size = size;
+	}
+
+	NEXTBLOCK(block)->prevsize = block->size;
+	NEXTBLOCK(newblock)->prevsize = newblock->size;
+
+	Z_InsertFree (newblock);
+    }
+
+    block->user = user;
+    block->id = ZONEID;
+    Z_LinkTag (block, tag);
+
+    result = (void *) ((byte *)block + sizeof(memblock_t));
+
+    if (block->user)
+    {
+	*block->user = result;
+    }
+
+    if (zonetrace)
+	Z_TraceMalloc (result, request, tag);
+
+    return result;
+}
+
+
+
+//
+// Z_FreeTags
+//
+void
+Z_FreeTags
+( int		lowtag,
+  int		hightag )
+{
+    memblock_t*	list;
+    int		tag;
+
+    if (zonetrace)
+	Z_TraceFreeTags (lowtag, hightag);
+
+    if (lowtag < PU_STATIC)
+	lowtag = PU_STATIC;
+
+    if (hightag > PU_NUM_TAGS - 1)
+	hightag = PU_NUM_TAGS - 1;
+
+    for (tag = lowtag ; tag <= hightag ; tag++)
+    {
+	list = &mainzone->taglists[tag];
+
+	while (list->next != list)
+	    Z_FreeBlock (list->next);
+    }
+}
+
+
+
+//
+// Z_DumpHeap
+// Note: TFileDumpHeap( stdout ) ?
+//
+void
+Z_DumpHeap
+( int		lowtag,
+  int		hightag )
+{
+    memblock_t*	block;
+
+    printf ("zone size: %i  location: %p\n",
+	    mainzone->size,mainzone);
+
+    printf ("tag range: %i to %i\n",
+	    lowtag, hightag);
+
+    for (block = mainzone->first ;
+	 block != mainzone->end ;
+	 block = NEXTBLOCK(block))
+    {
+	if (block->tag >= lowtag && block->tag <= hightag)
+	    printf ("block:%p    size:%7i    user:%p    tag:%3i\n",
+		    block, block->size, block->user, block->tag);
+
+	if (NEXTBLOCK(block)->prevsize != block->size)
+	    printf ("ERROR: block size does not touch the next block\n");
+
+	if (block->tag == PU_FREE && NEXTBLOCK(block)->tag == PU_FREE)
+	    printf ("ERROR: two consecutive free blocks\n");
+    }
+}
+
+
+//
+// Z_FileDumpHeap
+//
+void Z_FileDumpHeap (FILE* f)
+{
+    memblock_t*	block;
+
+    fprintf (f,"zone size: %i  location: %p\n",mainzone->size,mainzone);
+
+    for (block = mainzone->first ;
+	 block != mainzone->end ;
+	 block = NEXTBLOCK(block))
+    {
+	fprintf (f,"block:%p    size:%7i    user:%p    tag:%3i\n",
+		 block, block->size, block->user, block->tag);
+
+	if (NEXTBLOCK(block)->prevsize != block->size)
+	    fprintf (f,"ERROR: block size does not touch the next block\n");
+
+	if (block->tag == PU_FREE && NEXTBLOCK(block)->tag == PU_FREE)
+	    fprintf (f,"ERROR: two consecutive free blocks\n");
+    }
+}
+
+
+
+//
+// Z_CheckHeap
+//
+void Z_CheckHeap (void)
+{
+    memblock_t*	block;
+
+    for (block = mainzone->first ;
+	 block != mainzone->end ;
+	 block = NEXTBLOCK(block))
+    {
+	if ((byte *) block + block->size > (byte *) mainzone->end
+	 || NEXTBLOCK(block)->prevsize != block->size)
+	    I_Error ("Z_CheckHeap: block size does not touch the next block\n");
+
+	if (block->tag == PU_FREE && NEXTBLOCK(block)->tag == PU_FREE)
+	    I_Error ("Z_CheckHeap: two consecutive free blocks\n");
+
+	if (block->tag != PU_FREE
+	 && (block->next->prev != block || block->prev->next != block))
+	    I_Error ("Z_CheckHeap: block not on the list of its tag\n");
+    }
+}
+
+
+
+
+//
+// Z_ChangeTag
+//
+void Z_ChangeTag2(void *ptr, int tag, char *file, int line)
+{
+    memblock_t*	block;
+
+    block = (memblock_t *) ((byte *)ptr - sizeof(memblock_t));
+
+    if (block->id != ZONEID)
+        I_Error("%s:%i: Z_ChangeTag: block without a ZONEID!",
+                file, line);
+
+    if (tag >= PU_PURGELEVEL && block->user == NULL)
+        I_Error("%s:%i: Z_ChangeTag: an owner is required "
+                "for purgable blocks", file, line);
+
+    if (zonetrace)
+        Z_TraceChangeTag(ptr, tag);
+
+    Z_UnlinkTag(block);
+    Z_LinkTag(block, tag);
+}
+
+//
+// Z_Touch
+// Moves a purgable block to the end of its list, so that it is
+// purged after those used longer ago.
+//
+void Z_Touch (void *ptr)
+{
+    memblock_t*	block;
+
+    block = (memblock_t *) ((byte *)ptr - sizeof(memblock_t));
+
+    if (block->id != ZONEID)
+        I_Error("Z_Touch: block without a ZONEID!");
+
+    if (zonetrace)
+        Z_TraceTouch(ptr);
+
+    if (block->tag >= PU_PURGELEVEL
+     && block->next != &mainzone->taglists[block->tag])
+    {
+        Z_UnlinkTag(block);
+        Z_LinkTag(block, block->tag);
+    }
+}
+
+void Z_ChangeUser(void *ptr, void **user)
+{
+    memblock_t*	block;
+
+    block = (memblock_t *) ((byte *)ptr - sizeof(memblock_t));
+
+    if (block->id != ZONEID)
+    {
+        I_Error("Z_ChangeUser: Tried to change user for invalid block!");
+    }
+
+    block->user = user;
+    *user = ptr;
+}
+
+
+
+//
+// Z_FreeMemory
+//
+int Z_FreeMemory (void)
+{
+    memblock_t*		block;
+    int			free;
+
+    free = 0;
+
+    for (block = mainzone->first ;
+         block != mainzone->end ;
+         block = NEXTBLOCK(block))
+    {
+        if (block->tag == PU_FREE || block->tag >= PU_PURGELEVEL)
+            free += block->size;
+    }
+
+    return free;
+}
+
+unsigned int Z_ZoneSize(void)
+{
+    return mainzone->size;
+}
+
+#endif /* #ifdef ZONE_SEGFIT */
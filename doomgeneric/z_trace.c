@@ -0,0 +1,356 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Recording zone allocations to a file, and replaying them
+//	to time the zone allocator.
+//
+
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "doomtype.h"
+#include "i_system.h"
+#include "i_timer.h"
+#include "z_zone.h"
+#include "z_trace.h"
+
+
+//
+// A trace is a text file with a line for each call to the zone:
+//
+//	m <id> <size> <tag>	Z_Malloc, numbering blocks from 0
+//	f <id>			Z_Free
+//	t <id> <tag>		Z_ChangeTag
+//	u <id>			Z_Touch
+//	F <lowtag> <hightag>	Z_FreeTags
+//
+// Blocks purged by the zone are not in it.  Each zone purges
+// blocks of its own when the trace is replayed.
+//
+
+FILE*		zonetrace;
+
+// Number of each traced block, by address.  This is kept with
+// malloc, so that keeping it does not show up in the trace.
+typedef struct
+{
+    void*	ptr;
+    int		id;
+} traceblock_t;
+
+static traceblock_t*	traceblocks;
+static unsigned int	tracesize;
+static unsigned int	tracecount;
+static int		nexttraceid;
+
+#define TRACEHASH(ptr)	((unsigned int) (((size_t) (ptr) >> 3) * 2654435761u))
+
+#define REPLAYPASSES	100
+
+
+//
+// Z_FindTraceBlock
+// Returns the slot of ptr, or the empty slot where it would go.
+//
+static traceblock_t* Z_FindTraceBlock (void* ptr)
+{
+    unsigned int	i;
+
+    for (i = TRACEHASH(ptr) & (tracesize - 1) ;
+	 traceblocks[i].ptr != NULL && traceblocks[i].ptr != ptr ;
+	 i = (i + 1) & (tracesize - 1));
+
+    return &traceblocks[i];
+}
+
+
+//
+// Z_AddTraceBlock
+//
+static void Z_AddTraceBlock (void* ptr, int id)
+{
+    traceblock_t*	old;
+    traceblock_t*	slot;
+    unsigned int	oldsize;
+    unsigned int	i;
+
+    if ((tracecount + 1) * 2 > tracesize)
+    {
+	old = traceblocks;
+	oldsize = tracesize;
+
+	tracesize = tracesize ? tracesize * 2 : 1024;
+	traceblocks = calloc (tracesize, sizeof(*traceblocks));
+
+	if (traceblocks == NULL)
+	    I_Error ("Z_AddTraceBlock: failed to grow the block table");
+
+	for (i=0 ; i<oldsize ; i++)
+	{
+	    if (old[i].ptr != NULL)
+		*Z_FindTraceBlock (old[i].ptr) = old[i];
+	}
+
+	free (old);
+    }
+
+    slot = Z_FindTraceBlock (ptr);
+
+    // A block purged by the zone is still in the table until its
+    // memory is given out again.
+    if (slot->ptr == NULL)
+	tracecount++;
+
+    slot->ptr = ptr;
+    slot->id = id;
+}
+
+
+//
+// Z_TraceBlockId
+// Returns the number of the block at ptr, or -1.
+//
+static int Z_TraceBlockId (void* ptr)
+{
+    traceblock_t*	slot;
+
+    if (tracesize == 0)
+	return -1;
+
+    slot = Z_FindTraceBlock (ptr);
+
+    return slot->ptr != NULL ? slot->id : -1;
+}
+
+
+//
+// Z_StopTrace
+//
+static void Z_StopTrace (void)
+{
+    if (zonetrace != NULL)
+    {
+	fclose (zonetrace);
+	zonetrace = NULL;
+    }
+}
+
+
+//
+// Z_StartTrace
+//
+void Z_StartTrace (char* filename)
+{
+    zonetrace = fopen (filename, "w");
+
+    if (zonetrace == NULL)
+	I_Error ("Z_StartTrace: couldn't open %s", filename);
+
+    I_AtExit (Z_StopTrace, true);
+}
+
+
+void Z_TraceMalloc (void* ptr, int size, int tag)
+{
+    Z_AddTraceBlock (ptr, nexttraceid);
+    fprintf (zonetrace, "m %i %i %i\n", nexttraceid++, size, tag);
+}
+
+void Z_TraceFree (void* ptr)
+{
+    int		id;
+
+    id = Z_TraceBlockId (ptr);
+
+    if (id >= 0)
+	fprintf (zonetrace, "f %i\n", id);
+}
+
+void Z_TraceFreeTags (int lowtag, int hightag)
+{
+    fprintf (zonetrace, "F %i %i\n", lowtag, hightag);
+}
+
+void Z_TraceChangeTag (void* ptr, int tag)
+{
+    int		id;
+
+    id = Z_TraceBlockId (ptr);
+
+    if (id >= 0)
+	fprintf (zonetrace, "t %i %i\n", id, tag);
+}
+
+void Z_TraceTouch (void* ptr)
+{
+    int		id;
+
+    id = Z_TraceBlockId (ptr);
+
+    if (id >= 0)
+	fprintf (zonetrace, "u %i\n", id);
+}
+
+
+//
+// Z_ReplayTrace
+// Every block is given an owner, so that the replay knows when
+// the zone has purged one.  A block the trace goes on using
+// after that is allocated again, as W_CacheLumpNum would do.
+//
+typedef struct
+{
+    char	op;
+    int		a;
+    int		b;
+    int		c;
+} replayop_t;
+
+void Z_ReplayTrace (char* filename)
+{
+    FILE*	f;
+    char	line[64];
+    replayop_t*	ops;
+    replayop_t*	op;
+    int		numops;
+    int		maxops;
+    int		numblocks;
+    void**	blocks;
+    int*	sizes;
+    int*	tags;
+    int		reallocs;
+    int		pass;
+    int		start;
+    int		total;
+    int		i;
+
+    f = fopen (filename, "r");
+
+    if (f == NULL)
+	I_Error ("Z_ReplayTrace: couldn't open %s", filename);
+
+    ops = NULL;
+    numops = maxops = 0;
+    numblocks = 0;
+
+    while (fgets (line, sizeof(line), f) != NULL)
+    {
+	if (numops == maxops)
+	{
+	    maxops = maxops ? maxops * 2 : 4096;
+	    ops = realloc (ops, maxops * sizeof(*ops));
+
+	    if (ops == NULL)
+		I_Error ("Z_ReplayTrace: out of memory");
+	}
+
+	op = &ops[numops];
+	op->a = op->b = op->c = 0;
+
+	if (sscanf (line, "%c %i %i %i", &op->op, &op->a, &op->b, &op->c) < 2
+	 || op->a < 0)
+	{
+	    I_Error ("Z_ReplayTrace: bad line %i in %s", numops + 1, filename);
+	}
+
+	if (op->op != 'F' && op->a >= numblocks)
+	    numblocks = op->a + 1;
+
+	numops++;
+    }
+
+    fclose (f);
+
+    blocks = calloc (numblocks + 1, sizeof(*blocks));
+    sizes = calloc (numblocks + 1, sizeof(*sizes));
+    tags = calloc (numblocks + 1, sizeof(*tags));
+
+    if (blocks == NULL || sizes == NULL || tags == NULL)
+	I_Error ("Z_ReplayTrace: out of memory");
+
+    total = 0;
+    reallocs = 0;
+
+    for (pass=0 ; pass<REPLAYPASSES ; pass++)
+    {
+	start = I_GetTimeMS ();
+
+	for (i=0, op=ops ; i<numops ; i++, op++)
+	{
+	    switch (op->op)
+	    {
+	      case 'm':
+		sizes[op->a] = op->b;
+		tags[op->a] = op->c;
+		Z_Malloc (op->b, op->c, &blocks[op->a]);
+		break;
+
+	      case 'f':
+		if (blocks[op->a] != NULL)
+		    Z_Free (blocks[op->a]);
+		break;
+
+	      case 't':
+		tags[op->a] = op->b;
+
+		if (blocks[op->a] != NULL)
+		{
+		    Z_ChangeTag (blocks[op->a], op->b);
+		}
+		else
+		{
+		    Z_Malloc (sizes[op->a], op->b, &blocks[op->a]);
+		    reallocs++;
+		}
+		break;
+
+	      case 'u':
+		if (blocks[op->a] != NULL)
+		{
+		    Z_Touch (blocks[op->a]);
+		}
+		else
+		{
+		    Z_Malloc (sizes[op->a], tags[op->a], &blocks[op->a]);
+		    reallocs++;
+		}
+		break;
+
+	      case 'F':
+		Z_FreeTags (op->a, op->b);
+		break;
+
+	      default:
+		I_Error ("Z_ReplayTrace: unknown operation '%c'", op->op);
+	    }
+	}
+
+	total += I_GetTimeMS () - start;
+
+	// Empty the zone for the next pass.
+	Z_FreeTags (PU_STATIC, PU_NUM_TAGS - 1);
+    }
+
+    printf ("Z_ReplayTrace: %i operations on %i blocks, %i us a pass "
+	    "over %i passes, %i blocks allocated again after a purge\n",
+	    numops, numblocks, total * (1000 / REPLAYPASSES), REPLAYPASSES,
+	    reallocs / REPLAYPASSES);
+
+    free (tags);
+    free (sizes);
+    free (blocks);
+    free (ops);
+}
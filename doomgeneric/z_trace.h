@@ -0,0 +1,43 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Recording zone allocations to a file, and replaying them
+//	to time the zone allocator.
+//
+
+
+#ifndef __Z_TRACE__
+#define __Z_TRACE__
+
+#include <stdio.h>
+
+// The trace being recorded, or NULL.  The zone calls the
+// Z_Trace functions below only while this is set.
+extern FILE*	zonetrace;
+
+// Starts recording every call made to the zone into filename.
+void	Z_StartTrace (char *filename);
+
+void	Z_TraceMalloc (void *ptr, int size, int tag);
+void	Z_TraceFree (void *ptr);
+void	Z_TraceFreeTags (int lowtag, int hightag);
+void	Z_TraceChangeTag (void *ptr, int tag);
+void	Z_TraceTouch (void *ptr);
+
+// Replays a recorded trace into the empty zone, several times
+// over, and prints how long it took.
+void	Z_ReplayTrace (char *filename);
+
+#endif
@@ -14,13 +14,17 @@
 //
 // DESCRIPTION:
 //	Zone Memory Allocation. Neat.
+//	Built unless ZONE_SEGFIT selects the zone in z_segfit.c.
 //
 
 
 #include "z_zone.h"
+#include "z_trace.h"
 #include "i_system.h"
 #include "doomtype.h"
 
+#ifndef ZONE_SEGFIT
+
 
 //
 // ZONE MEMORY ALLOCATION
@@ -31,6 +35,9 @@
 //
 // It is of no value to free a cachable block,
 //  because it will get overwritten automatically if needed.
+//
+// When the rover is not at a free block big enough, the purgable
+//  blocks used longest ago are thrown out first.
 // 
  
 #define MEM_ALIGN sizeof(void *)
@@ -39,6 +46,7 @@
 typedef struct memblock_s
 {
     int			size;	// including the header and possibly tiny fragments
+    unsigned int	lastuse; // zone clock when last used
     void**		user;
     int			tag;	// PU_FREE if this is free
     int			id;	// should be ZONEID
@@ -56,6 +64,9 @@ typedef struct
     memblock_t	blocklist;
     
     memblock_t*	rover;
+
+    // advanced by each allocation
+    unsigned int	clock;
     
 } memzone_t;
 
@@ -121,9 +132,10 @@ void Z_Init (void)
 
 
 //
-// Z_Free
+// Z_FreeBlock
+// Frees a block for Z_Free, or to purge it or free its tag.
 //
-void Z_Free (void* ptr)
+static void Z_FreeBlock (void* ptr)
 {
     memblock_t*		block;
     memblock_t*		other;
@@ -173,6 +185,85 @@ void Z_Free (void* ptr)
 }
 
 
+//
+// Z_Free
+//
+void Z_Free (void* ptr)
+{
+    if (zonetrace)
+	Z_TraceFree (ptr);
+
+    Z_FreeBlock (ptr);
+}
+
+
+
+//
+// Z_FindBase
+// Looks around the zone from the rover for runs of free and
+// purgable blocks big enough for size bytes, and returns the start
+// of the run whose most recently used block was used longest ago.
+// A free block big enough is taken at once.
+//
+static memblock_t* Z_FindBase (int size)
+{
+    memblock_t*		first;
+    memblock_t*		block;
+    memblock_t*		other;
+    memblock_t*		best;
+    unsigned int	bestuse;
+    unsigned int	lastuse;
+    int			runsize;
+
+    best = NULL;
+    bestuse = 0;
+    block = first = mainzone->rover;
+    runsize = 0;
+
+    do
+    {
+	if (block == &mainzone->blocklist
+	 || (block->tag != PU_FREE && block->tag < PU_PURGELEVEL))
+	{
+	    // a run can't go past a block that can't be purged
+	    first = block->next;
+	    runsize = 0;
+	    continue;
+	}
+
+	if (block->tag == PU_FREE && block->size >= size)
+	    return block;
+
+	runsize += block->size;
+
+	// keep the run as short as it can be
+	while (runsize - first->size >= size)
+	{
+	    runsize -= first->size;
+	    first = first->next;
+	}
+
+	if (runsize < size)
+	    continue;
+
+	lastuse = 0;
+
+	for (other = first ; other != block->next ; other = other->next)
+	{
+	    if (other->tag != PU_FREE && other->lastuse > lastuse)
+		lastuse = other->lastuse;
+	}
+
+	if (best == NULL || lastuse < bestuse)
+	{
+	    best = first;
+	    bestuse = lastuse;
+	}
+    } while ((block = block->next) != mainzone->rover);
+
+    return best;
+}
+
 
 //
 // Z_Malloc
@@ -193,7 +284,9 @@ Z_Malloc
     memblock_t* newblock;
     memblock_t*	base;
     void *result;
+    int		request;
 
+    request = size;
     size = (size + MEM_ALIGN - 1) & ~(MEM_ALIGN - 1);
     
     // scan through the block list,
@@ -210,6 +303,18 @@ Z_Malloc
     
     if (base->prev->tag == PU_FREE)
         base = base->prev;
+
+    // otherwise purge the blocks used longest ago
+    if (base->tag != PU_FREE || base->size < size)
+    {
+        base = Z_FindBase (size);
+
+        if (base == NULL)
+            I_Error ("Z_Malloc: failed on allocation of %i bytes", size);
+
+        if (base->prev->tag == PU_FREE)
+            base = base->prev;
+    }
 	
     rover = base;
     start = base->prev;
@@ -236,7 +341,7 @@ Z_Malloc
 
                 // the rover can be the base block
                 base = base->prev;
-                Z_Free ((byte *)rover+sizeof(memblock_t));
+                Z_FreeBlock ((byte *)rover+sizeof(memblock_t));
                 base = base->next;
                 rover = base->next;
             }
@@ -273,6 +378,7 @@ Z_Malloc
 
     base->user = user;
     base->tag = tag;
+    base->lastuse = ++mainzone->clock;
 
     result  = (void *) ((byte *)base + sizeof(memblock_t));
 
@@ -285,6 +391,9 @@ Z_Malloc
     mainzone->rover = base->next;	
 	
     base->id = ZONEID;
+
+    if (zonetrace)
+	Z_TraceMalloc (result, request, tag);
     
     return result;
 }
@@ -301,6 +410,9 @@ Z_FreeTags
 {
     memblock_t*	block;
     memblock_t*	next;
+
+    if (zonetrace)
+	Z_TraceFreeTags (lowtag, hightag);
 	
     for (block = mainzone->blocklist.next ;
 	 block != &mainzone->blocklist ;
@@ -314,7 +426,7 @@ Z_FreeTags
 	    continue;
 	
 	if (block->tag >= lowtag && block->tag <= hightag)
-	    Z_Free ( (byte *)block+sizeof(memblock_t));
+	    Z_FreeBlock ( (byte *)block+sizeof(memblock_t));
     }
 }
 
@@ -440,9 +552,32 @@ void Z_ChangeTag2(void *ptr, int tag, char *file, int line)
         I_Error("%s:%i: Z_ChangeTag: an owner is required "
                 "for purgable blocks", file, line);
 
+    if (zonetrace)
+        Z_TraceChangeTag(ptr, tag);
+
     block->tag = tag;
 }
 
+//
+// Z_Touch
+// Marks a block as used, so that it is purged after those
+// used longer ago.
+//
+void Z_Touch (void *ptr)
+{
+    memblock_t*	block;
+
+    block = (memblock_t *) ((byte *)ptr - sizeof(memblock_t));
+
+    if (block->id != ZONEID)
+        I_Error("Z_Touch: block without a ZONEID!");
+
+    if (zonetrace)
+        Z_TraceTouch(ptr);
+
+    block->lastuse = mainzone->clock;
+}
+
 void Z_ChangeUser(void *ptr, void **user)
 {
     memblock_t*	block;
@@ -486,3 +621,4 @@ unsigned int Z_ZoneSize(void)
     return mainzone->size;
 }
 
+#endif /* #ifndef ZONE_SEGFIT */